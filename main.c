@@ -18,11 +18,24 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <limits.h>
 #include <inttypes.h>
 #include <time.h>
 #include <signal.h>
 #include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <malloc.h>
 #include <stdatomic.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
 
 #ifdef HAVE_LIBFTDI1
 #	include <libftdi1/ftdi.h>
@@ -30,7 +43,16 @@
 #	include <ftdi.h>
 #endif // HAVE_LIBFTDI1
 
+#if defined(HAVE_LIBUSB)
+#	include <libusb.h>
+#endif
+
+#if defined(HAVE_LIBURING)
+#	include <liburing.h>
+#endif
+
 #include <osc.lv2/stream.h>
+#include <osc.lv2/writer.h>
 
 #include <varchunk.h>
 #include <osc2ftdidmx.h>
@@ -39,31 +61,255 @@
 #define FT232_PID  0x6001
 #define NSECS      1000000000
 #define JAN_1970   2208988800ULL
+#define DMX_BAUD   250000
+#define FTDI_TEMT  0x4000 // transmitter empty in line status of modem status
+
+#define PREFAULT_HEAP  0x100000 // 1 M
+#define PREFAULT_STACK 0x10000 // 64 K
+
+#define RX_BUF_SIZE    0x10000 // 64 K
+
+#define MAX_PORTS      32
+#define MAX_INPUTS     16
+#define PATCH_UNIVERSES 64
+#define BACKOFF_MIN_MS 100
+#define BACKOFF_MAX_MS 5000
+
+#define TB_INDEX       0x3
+#define TB_FRESH       0x4
 
-//#define FTDI_SKIP
+#define SELFTEST_FRAMES 8
+#define PTY_QUEUE      0x1000 // 4 K, tty line discipline buffer
+
+#define URING_ENTRIES  8
+#define URING_BUFS     128 // provided buffers, power of two
+#define URING_BUF_SIZE 0x2000 // 8 K, receive header, peer name and payload
+#define URING_BGID     0
+
+typedef enum _stat_t {
+	STAT_SLEEP,
+	STAT_WAKEUP,
+	STAT_DISPATCH,
+	STAT_BREAK,
+	STAT_XMIT,
+	STAT_FLIGHT,
+
+	STAT_MAX
+} stat_t;
+
+// io_uring completion sources
+typedef enum _uring_tag_t {
+	URING_RECV,
+	URING_WAKE,
+	URING_QUIT
+} uring_tag_t;
 
 typedef struct _sched_t sched_t;
+typedef struct _frame_t frame_t;
+typedef struct _snap_t snap_t;
+typedef struct _port_t port_t;
 typedef struct _app_t app_t;
+typedef struct _backend_t backend_t;
+typedef struct _record_t record_t;
+typedef struct _input_t input_t;
+
+struct _backend_t {
+	const char *name;
+	bool usb;
+	bool path;
+	int (*init)(app_t *app, port_t *port);
+	void (*deinit)(port_t *port);
+	int (*xmit)(app_t *app, port_t *port);
+	int (*selftest)(app_t *app, port_t *port);
+};
 
 struct _sched_t {
 	sched_t *next;
+	input_t *input;
+	uint32_t reply_to;
 	struct timespec to;
 	size_t len;
 	uint8_t buf [];
 };
 
+// header of frames in file and pty output, in host byte order
+struct _record_t {
+	uint64_t timestamp; // ns since epoch
+	uint16_t universe;
+	uint16_t size; // start code and slots
+} __attribute__((packed));
+
+// OSC socket with its own rings, served by its own input thread
+struct _input_t {
+	app_t *app;
+	LV2_OSC_Stream stream;
+	pthread_t thread;
+	int wake; // eventfd signalled upon pending replies
+	int fds [LV2_OSC_STREAM_CLIENTS]; // watched TCP client connections
+
+	struct {
+		varchunk_t *rx;
+		varchunk_t *tx;
+	} rb;
+
+#if defined(HAVE_LIBURING)
+	struct {
+		struct io_uring ring;
+		struct io_uring_buf_ring *br;
+		uint8_t *bufs;
+		struct msghdr msg;
+	} uring;
+#endif
+};
+
+struct _frame_t {
+	uint32_t nslots;
+	uint8_t data [512];
+};
+
+// adapter statistics as published by the thread owning the adapter
+struct _snap_t {
+	hist_t stat [STAT_MAX];
+	uint64_t frames;
+	uint64_t ctrl;
+	uint64_t bulk;
+};
+
+struct _port_t {
+	app_t *app;
+	const char *sid;
+	const char *des;
+	uint16_t universe;
+	uint32_t nslots;
+	port_t *mirror;
+	atomic_bool offline;
+	atomic_bool quiesced; // owning thread no longer touches an offline port
+	bool open;
+	bool stale;
+	bool tested;
+
+	struct {
+		uint32_t ms;
+		struct timespec next;
+		bool parked;
+	} backoff;
+
+#if defined(HAVE_LIBUSB)
+	struct {
+		uint8_t bus;
+		uint8_t addr;
+	} hotplug;
+#endif
+
+	pthread_t thread;
+	uint32_t fps;
+	uint64_t step_ns;
+	bool max_rate;
+	uint64_t phase_ns;
+
+	struct {
+		atomic_uint latest;
+		uint32_t back;
+		uint32_t front;
+		frame_t buf [3];
+	} tb;
+
+	hist_t stat [STAT_MAX];
+
+	struct {
+		atomic_uint latest;
+		uint32_t back;
+		uint32_t front;
+		snap_t buf [3];
+	} snap;
+
+	bool patched;
+	gather_t gather;
+
+	struct ftdi_context ftdi;
+
+	struct {
+		int fd;
+		int slave;
+	} sink;
+
+	struct {
+		uint8_t buf [PRO_OVERHEAD + 1 + 512];
+	} pro;
+
+	struct {
+		struct ftdi_transfer_control *tc;
+		int len;
+		struct timespec submit;
+	} async;
+
+	struct {
+		bool pending;
+		struct timespec until; // latest time the last frame leaves the wire
+	} drain;
+
+	struct {
+		uint64_t frames;
+		uint64_t ctrl;
+		uint64_t bulk;
+	} usb;
+
+	uint8_t prev [512];
+
+	uint32_t cur;
+	struct {
+		uint8_t start_code [1];
+		uint8_t data [512];
+	} __attribute__((packed)) dmx [2];
+};
+
 struct _app_t {
 	uint16_t vid;
 	uint16_t pid;
-	const char *sid;
-	const char *des;
 	uint32_t fps;
+	uint64_t step_ns;
+	bool max_rate;
+	uint32_t slots;
 	const char *url;
 
-	LV2_OSC_Stream stream;
+	struct {
+		uint32_t break_us;
+		uint32_t mab_us;
+	} timing;
+
+	struct {
+		uint8_t latency_ms;
+		uint32_t chunksize;
+		bool selftest;
+	} usb_cfg;
+
+	struct {
+		uint32_t frames;
+		struct timespec from;
+		float achieved;
+	} rate;
+
+	uint32_t ninputs;
+	input_t inputs [MAX_INPUTS];
+	input_t *reply; // input the currently dispatched packet arrived on
+	uint32_t reply_to; // stream source the currently dispatched packet came from
 	pthread_t thread;
 
-	struct ftdi_context ftdi;
+	uint32_t nports;
+	port_t ports [MAX_PORTS];
+
+	const backend_t *backend;
+
+	struct {
+		const char *path;
+	} sink;
+
+	struct {
+		const char *path;
+		uint32_t nuniv;
+		uint16_t univ [PATCH_UNIVERSES];
+		uint8_t buf [PATCH_UNIVERSES*512 + 1];
+	} patch;
 
 	sched_t *list;
 
@@ -73,58 +319,198 @@ struct _app_t {
 	} priority;
 
 	struct {
-		varchunk_t *rx;
-		varchunk_t *tx;
-	} rb;
+		int out;
+		int inp;
+	} affinity;
+
+	bool prefault;
+	bool single;
+	bool workers;
+	bool stagger;
+
+	struct {
+		bool enabled;
+		bool pending;
+		uint32_t fps;
+		sem_t sem;
+		struct timespec last;
+	} adaptive;
+
+	struct {
+		bool enabled;
+		bool calibrate;
+		uint64_t margin_ns;
+		hist_t window; // sleep lateness since last calibration
+	} spin;
+
+	uint8_t rx_buf [RX_BUF_SIZE];
 
 	state_t state;
 
+	hist_t stat [STAT_MAX];
+
 	struct {
-		uint8_t start_code [1];
-		uint8_t data [512];
-	} __attribute__((packed)) dmx;
+		bool enabled;
+	} async;
+
+	struct {
+		bool enabled;
+	} uring;
+
+	struct {
+		bool enabled;
+		pthread_t thread;
+		int wake; // eventfd signalled upon reconnects in single-thread mode
+	} recover;
+
+#if defined(HAVE_LIBUSB)
+	struct {
+		libusb_context *ctx;
+		libusb_hotplug_callback_handle handle;
+	} hotplug;
+#endif
 };
 
 static atomic_bool reconnect = ATOMIC_VAR_INIT(false);
 static atomic_bool done = ATOMIC_VAR_INIT(false);
+static atomic_bool dump = ATOMIC_VAR_INIT(false);
+static int quit = -1; // eventfd signalled upon shutdown
+
+static const LV2_OSC_Tree tree_stat_item [STAT_MAX+3];
+static const LV2_OSC_Tree tree_stat [1+1];
+
+static void
+_quit(void)
+{
+	atomic_store(&done, true);
+
+	// wake up threads blocking in epoll
+	if(quit >= 0)
+	{
+		eventfd_write(quit, 1);
+	}
+}
 
 static void
 _sig(int num __attribute__((unused)))
 {
 	atomic_store(&reconnect, false);
-	atomic_store(&done, true);
+	_quit();
+}
+
+static void
+_sig_dump(int num __attribute__((unused)))
+{
+	atomic_store(&dump, true);
+}
+
+static inline int64_t
+_ts_diff(const struct timespec *a, const struct timespec *b)
+{
+	return (a->tv_sec - b->tv_sec) * NSECS + (a->tv_nsec - b->tv_nsec);
+}
+
+static inline void
+_ts_add(struct timespec *ts, int64_t ns)
+{
+	ts->tv_sec += ns / NSECS;
+	ts->tv_nsec += ns % NSECS;
+
+	if(ts->tv_nsec >= NSECS)
+	{
+		ts->tv_sec += 1;
+		ts->tv_nsec -= NSECS;
+	}
+	else if(ts->tv_nsec < 0)
+	{
+		ts->tv_sec -= 1;
+		ts->tv_nsec += NSECS;
+	}
+}
+
+static inline uint64_t
+_ts_lapse(const struct timespec *a, const struct timespec *b)
+{
+	const int64_t diff = _ts_diff(a, b);
+
+	return diff > 0
+		? diff
+		: 0;
+}
+
+// packets in the rx ringbuffer are preceded by the stream source they arrived
+// from, replies in the tx ringbuffer by the stream source they go to
+static uint8_t *
+_rb_write_req(varchunk_t *rb, uint32_t source, size_t minimum, size_t *maximum)
+{
+	size_t max_len;
+	uint8_t *buf = varchunk_write_request_max(rb, sizeof(source) + minimum, &max_len);
+	if(!buf)
+	{
+		return NULL;
+	}
+
+	memcpy(buf, &source, sizeof(source));
+
+	if(maximum)
+	{
+		*maximum = max_len - sizeof(source);
+	}
+
+	return buf + sizeof(source);
+}
+
+static const uint8_t *
+_rb_read_req(varchunk_t *rb, uint32_t *source, size_t *toread)
+{
+	const uint8_t *buf = varchunk_read_request(rb, toread);
+	if(!buf)
+	{
+		return NULL;
+	}
+
+	memcpy(source, buf, sizeof(*source));
+	*toread -= sizeof(*source);
+
+	return buf + sizeof(*source);
 }
 
 static void *
 _write_req(void *data, size_t minimum, size_t *maximum)
 {
-	app_t *app = data;
+	input_t *input = data;
 
-	return varchunk_write_request_max(app->rb.rx, minimum, maximum);
+	return _rb_write_req(input->rb.rx, input->stream.source, minimum, maximum);
 }
 
 static void
 _write_adv(void *data, size_t written)
 {
-	app_t *app = data;
+	input_t *input = data;
+	app_t *app = input->app;
 
-	varchunk_write_advance(app->rb.rx, written);
+	varchunk_write_advance(input->rb.rx, sizeof(uint32_t) + written);
+
+	if(app->adaptive.enabled)
+	{
+		sem_post(&app->adaptive.sem); // wake up output thread
+	}
 }
 
 static const void *
 _read_req(void *data, size_t *toread)
 {
-	app_t *app = data;
+	input_t *input = data;
 
-	return varchunk_read_request(app->rb.tx, toread);
+	return _rb_read_req(input->rb.tx, &input->stream.dest, toread);
 }
 
 static void
 _read_adv(void *data)
 {
-	app_t *app = data;
+	input_t *input = data;
 
-	varchunk_read_advance(app->rb.tx);
+	varchunk_read_advance(input->rb.tx);
 }
 
 static const LV2_OSC_Driver driver = {
@@ -138,19 +524,11 @@ static void
 _handle_osc_packet(app_t *app, uint64_t timetag, const uint8_t *buf, size_t len);
 
 static void
-_handle_osc_message(app_t *app __attribute__((unused)), LV2_OSC_Reader *reader,
-	size_t len)
+_handle_osc_message(app_t *app, LV2_OSC_Reader *reader, size_t len)
 {
-	state_t *state = &app->state;
-
-	state->cur_channel = 0;
-	state->cur_value = 0;
-	state->cur_set = false;
-
-	state->cur_reader = *reader;
-	state->cur_arg = OSC_READER_MESSAGE_BEGIN(&state->cur_reader, len);
-
-	lv2_osc_reader_match(reader, len, tree_root, state);
+	LV2_OSC_Reader reader_clone = *reader;
+	state_dispatch(&app->state, &reader_clone, len);
+	lv2_osc_reader_match(reader, len, tree_stat, app);
 }
 
 static void
@@ -215,6 +593,8 @@ _handle_osc_packet(app_t *app, uint64_t timetag, const uint8_t *buf, size_t len)
 			if(elmnt)
 			{
 				elmnt->next = NULL;
+				elmnt->input = app->reply;
+				elmnt->reply_to = app->reply_to;
 				elmnt->to.tv_sec = (timetag >> 32) - JAN_1970;
 				elmnt->to.tv_nsec = (timetag && 32) * 0x1p-32 * 1e9;
 				elmnt->len = len;
@@ -230,300 +610,3015 @@ _handle_osc_packet(app_t *app, uint64_t timetag, const uint8_t *buf, size_t len)
 	}
 }
 
-static int
-_ftdi_xmit(app_t *app)
+static void *
+_write_req_direct(void *data, size_t minimum, size_t *maximum)
 {
-#if !defined(FTDI_SKIP)
-	if(ftdi_set_line_property2(&app->ftdi, BITS_8, STOP_BIT_2, NONE,
-		BREAK_ON) != 0)
-	{
-		goto failure;
-	}
+	input_t *input = data;
+	app_t *app = input->app;
 
-	if(ftdi_set_line_property2(&app->ftdi, BITS_8, STOP_BIT_2, NONE,
-		BREAK_OFF) != 0)
+	if(minimum > sizeof(app->rx_buf))
 	{
-		goto failure;
+		if(maximum)
+		{
+			*maximum = 0;
+		}
+
+		return NULL;
 	}
 
-	const ssize_t sz = sizeof(app->dmx.start_code) + sizeof(app->dmx.data);
-	if(ftdi_write_data(&app->ftdi, app->dmx.start_code, sz) != sz)
+	if(maximum)
 	{
-		goto failure;
+		*maximum = sizeof(app->rx_buf);
 	}
-#else
-	(void)app;
-#endif
 
-	return 0;
+	return app->rx_buf;
+}
 
-#if !defined(FTDI_SKIP)
-failure:
-	syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
-	return 1;
-#endif
+static void
+_write_adv_direct(void *data, size_t written)
+{
+	input_t *input = data;
+	app_t *app = input->app;
+
+	app->reply = input;
+	app->reply_to = input->stream.source;
+	_handle_osc_packet(app, LV2_OSC_IMMEDIATE, app->rx_buf, written);
+
+	app->adaptive.pending = true;
 }
 
-static int
-_ftdi_init(app_t *app)
+static const LV2_OSC_Driver driver_direct = {
+	.write_req = _write_req_direct,
+	.write_adv = _write_adv_direct,
+	.read_req = _read_req,
+	.read_adv = _read_adv
+};
+
+static uint8_t *
+_reply_request(app_t *app, size_t minimum, size_t *maximum)
 {
-#if !defined(FTDI_SKIP)
-	app->ftdi.module_detach_mode = AUTO_DETACH_SIO_MODULE;
+	return _rb_write_req(app->reply->rb.tx, app->reply_to, minimum, maximum);
+}
 
-	if(ftdi_init(&app->ftdi) != 0)
-	{
-		goto failure;
-	}
+static void
+_reply_advance(app_t *app, size_t written)
+{
+	varchunk_write_advance(app->reply->rb.tx, sizeof(uint32_t) + written);
 
-	if(ftdi_set_interface(&app->ftdi, INTERFACE_ANY) != 0)
+	// wake up input thread to send it
+	if(!app->single)
 	{
-		goto failure_deinit;
+		eventfd_write(app->reply->wake, 1);
 	}
+}
 
-	if(app->des || app->sid)
-	{
-		if(ftdi_usb_open_desc(&app->ftdi, app->vid, app->pid,
-			app->des, app->sid) != 0)
-		{
-			goto failure_deinit;
-		}
-	}
-	else
+static void
+_stat_reply(app_t *app, const char *path, const hist_t *hist)
+{
+	size_t max_len;
+	uint8_t *buf = _reply_request(app, 1024, &max_len);
+	if(!buf)
 	{
-		if(ftdi_usb_open(&app->ftdi, app->vid, app->pid) != 0)
-		{
-			goto failure_deinit;
-		}
+		syslog(LOG_WARNING, "[%s] ringbuffer overflow", __func__);
+		return;
 	}
 
-	if(ftdi_usb_reset(&app->ftdi) != 0)
-	{
-		goto failure_close;
-	}
+	char fmt [3 + HIST_BUCKETS + 1];
+	memset(fmt, LV2_OSC_INT32, sizeof(fmt) - 1);
+	memset(fmt, LV2_OSC_INT64, 3);
+	fmt[sizeof(fmt) - 1] = '\0';
 
-	if(ftdi_set_baudrate(&app->ftdi, 250000) != 0)
-	{
-		goto failure_close;
-	}
+	LV2_OSC_Writer writer;
+	lv2_osc_writer_initialize(&writer, buf, max_len);
 
-	if(ftdi_set_line_property2(&app->ftdi, BITS_8, STOP_BIT_2, NONE,
-		BREAK_ON) != 0)
-	{
-		goto failure_close;
-	}
+	bool success = lv2_osc_writer_add_path(&writer, path)
+		&& lv2_osc_writer_add_format(&writer, fmt)
+		&& lv2_osc_writer_add_int64(&writer, hist->count)
+		&& lv2_osc_writer_add_int64(&writer, hist->count ? hist->min : 0)
+		&& lv2_osc_writer_add_int64(&writer, hist->max);
 
-	if(ftdi_usb_purge_buffers(&app->ftdi) != 0)
+	for(uint32_t i = 0; success && (i < HIST_BUCKETS); i++)
 	{
-		goto failure_close;
+		success = lv2_osc_writer_add_int32(&writer, hist->buckets[i]);
 	}
 
-	if(ftdi_setflowctrl(&app->ftdi, SIO_DISABLE_FLOW_CTRL) != 0)
+	size_t written;
+	if(success && lv2_osc_writer_finalize(&writer, &written))
 	{
-		goto failure_close;
+		_reply_advance(app, written);
 	}
+}
 
-	if(ftdi_setrts(&app->ftdi, 0) != 0)
-	{
-		goto failure_close;
-	}
-#else
-	(void)app;
-#endif
+static void
+_stat_publish(port_t *port)
+{
+	snap_t *snap = &port->snap.buf[port->snap.back];
 
-	return 0;
+	memcpy(snap->stat, port->stat, sizeof(snap->stat));
+	snap->frames = port->usb.frames;
+	snap->ctrl = port->usb.ctrl;
+	snap->bulk = port->usb.bulk;
 
-#if !defined(FTDI_SKIP)
-failure_close:
-	ftdi_usb_close(&app->ftdi);
+	port->snap.back = atomic_exchange_explicit(&port->snap.latest,
+		port->snap.back | TB_FRESH, memory_order_acq_rel) & TB_INDEX;
+}
 
-failure_deinit:
-	ftdi_deinit(&app->ftdi);
+static const snap_t *
+_stat_snap(port_t *port)
+{
+	// adapter statistics are only read via snapshots, never live
+	if(atomic_load_explicit(&port->snap.latest, memory_order_acquire) & TB_FRESH)
+	{
+		port->snap.front = atomic_exchange_explicit(&port->snap.latest,
+			port->snap.front, memory_order_acq_rel) & TB_INDEX;
+	}
 
-failure:
-	syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
-	return -1;
-#endif
+	return &port->snap.buf[port->snap.front];
 }
 
 static void
-_ftdi_deinit(app_t *app)
+_stat_collect(app_t *app, stat_t stat, hist_t *hist)
 {
-#if !defined(FTDI_SKIP)
-	if(ftdi_usb_close(&app->ftdi) != 0)
+	*hist = app->stat[stat];
+
+	for(uint32_t i = 0; i < app->nports; i++)
 	{
-		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		hist_merge(hist, &_stat_snap(&app->ports[i])->stat[stat]);
 	}
+}
 
-	ftdi_deinit(&app->ftdi);
-#else
-	(void)app;
-#endif
+static void
+_stat(LV2_OSC_Reader *reader __attribute__((unused)),
+	LV2_OSC_Arg *arg __attribute__((unused)), const LV2_OSC_Tree *tree, void *data)
+{
+	app_t *app = data;
+
+	const stat_t stat = tree - tree_stat_item;
+
+	char path [32];
+	snprintf(path, sizeof(path), "/stat/%s", tree->name);
+
+	hist_t hist;
+	_stat_collect(app, stat, &hist);
+
+	_stat_reply(app, path, &hist);
 }
 
 static void
-_osc_deinit(app_t *app)
+_stat_rate(LV2_OSC_Reader *reader __attribute__((unused)),
+	LV2_OSC_Arg *arg __attribute__((unused)),
+	const LV2_OSC_Tree *tree __attribute__((unused)), void *data)
 {
-	lv2_osc_stream_deinit(&app->stream);
+	app_t *app = data;
 
-	if(app->rb.rx)
+	uint8_t *buf = _reply_request(app, 64, NULL);
+	if(!buf)
 	{
-		varchunk_free(app->rb.rx);
+		syslog(LOG_WARNING, "[%s] ringbuffer overflow", __func__);
+		return;
 	}
 
-	if(app->rb.tx)
+	LV2_OSC_Writer writer;
+	lv2_osc_writer_initialize(&writer, buf, 64);
+
+	size_t written;
+	if(  lv2_osc_writer_message_vararg(&writer, "/stat/rate", "ff",
+			(float)NSECS / app->step_ns, app->rate.achieved)
+		&& lv2_osc_writer_finalize(&writer, &written) )
 	{
-		varchunk_free(app->rb.tx);
+		_reply_advance(app, written);
 	}
 }
 
+static void
+_stat_usb(LV2_OSC_Reader *reader __attribute__((unused)),
+	LV2_OSC_Arg *arg __attribute__((unused)),
+	const LV2_OSC_Tree *tree __attribute__((unused)), void *data)
+{
+	app_t *app = data;
+	uint64_t frames = 0;
+	uint64_t ctrl = 0;
+	uint64_t bulk = 0;
+
+	// sum over all adapters
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		const snap_t *snap = _stat_snap(&app->ports[i]);
+
+		frames += snap->frames;
+		ctrl += snap->ctrl;
+		bulk += snap->bulk;
+	}
+
+	uint8_t *buf = _reply_request(app, 64, NULL);
+	if(!buf)
+	{
+		syslog(LOG_WARNING, "[%s] ringbuffer overflow", __func__);
+		return;
+	}
+
+	LV2_OSC_Writer writer;
+	lv2_osc_writer_initialize(&writer, buf, 64);
+
+	size_t written;
+	if(  lv2_osc_writer_message_vararg(&writer, "/stat/usb", "hhh",
+			frames, ctrl, bulk)
+		&& lv2_osc_writer_finalize(&writer, &written) )
+	{
+		_reply_advance(app, written);
+	}
+}
+
+static const LV2_OSC_Tree tree_stat_item [STAT_MAX+3] = {
+	[STAT_SLEEP]    = { .name = "sleep",    .branch = _stat },
+	[STAT_WAKEUP]   = { .name = "wakeup",   .branch = _stat },
+	[STAT_DISPATCH] = { .name = "dispatch", .branch = _stat },
+	[STAT_BREAK]    = { .name = "break",    .branch = _stat },
+	[STAT_XMIT]     = { .name = "xmit",     .branch = _stat },
+	[STAT_FLIGHT]   = { .name = "flight",   .branch = _stat },
+	[STAT_MAX]      = { .name = "rate",     .branch = _stat_rate },
+	[STAT_MAX+1]    = { .name = "usb",      .branch = _stat_usb },
+	[STAT_MAX+2]    = { .name = NULL }
+};
+
+static const LV2_OSC_Tree tree_stat [1+1] = {
+	{ .name = "stat", .trees = tree_stat_item },
+	{ .name = NULL }
+};
+
+static void
+_stat_dump(app_t *app)
+{
+	for(stat_t stat = 0; stat < STAT_MAX; stat++)
+	{
+		hist_t hist;
+		_stat_collect(app, stat, &hist);
+
+		syslog(LOG_NOTICE, "[%s] %s count: %"PRIu64" min: %"PRIu64" ns max: %"PRIu64" ns",
+			__func__, tree_stat_item[stat].name, hist.count,
+			hist.count ? hist.min : 0, hist.max);
+
+		for(uint32_t i = 0; i < HIST_BUCKETS; i++)
+		{
+			if(hist.buckets[i])
+			{
+				syslog(LOG_NOTICE, "[%s]   >= %"PRIu64" ns: %"PRIu32,
+					__func__, i ? (UINT64_C(1) << i) : 0, hist.buckets[i]);
+			}
+		}
+	}
+
+	syslog(LOG_NOTICE, "[%s] rate target: %.2f fps achieved: %.2f fps",
+		__func__, (double)NSECS / app->step_ns, app->rate.achieved);
+
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		port_t *port = &app->ports[i];
+		const snap_t *snap = _stat_snap(port);
+
+		if(snap->frames)
+		{
+			syslog(LOG_NOTICE, "[%s] usb %"PRIu32" frames: %"PRIu64" control/frame: %.2f bulk/frame: %.2f",
+				__func__, i, snap->frames, (double)snap->ctrl / snap->frames,
+				(double)snap->bulk / snap->frames);
+		}
+
+		if(atomic_load(&port->offline))
+		{
+			syslog(LOG_NOTICE, "[%s] usb %"PRIu32" offline", __func__, i);
+		}
+	}
+}
+
+static void
+_stat_rate_update(app_t *app, const struct timespec *now)
+{
+	app->rate.frames++;
+
+	const int64_t elapsed = _ts_diff(now, &app->rate.from);
+
+	if(elapsed >= NSECS)
+	{
+		app->rate.achieved = (float)app->rate.frames * NSECS / elapsed;
+		app->rate.frames = 0;
+		app->rate.from = *now;
+	}
+}
+
+static void
+_hold(uint32_t us)
+{
+	struct timespec to;
+	clock_gettime(CLOCK_MONOTONIC, &to);
+	_ts_add(&to, us * 1000);
+
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &to, NULL) == EINTR)
+	{
+		// try again
+	}
+}
+
+static void
+_ftdi_drain_arm(port_t *port, int len)
+{
+	// bulk transfers complete once the data is in the device FIFO, at the
+	// latest it has left the wire after the wire time of all of it
+	clock_gettime(CLOCK_MONOTONIC, &port->drain.until);
+	_ts_add(&port->drain.until, dmx_wire_ns(len));
+	port->drain.pending = true;
+}
+
+static int
+_ftdi_drain(port_t *port)
+{
+	// equivalent of tcdrain, a break must not cut off the previous frame
+	if(!port->drain.pending)
+	{
+		return 0;
+	}
+
+	port->drain.pending = false;
+
+	while(true)
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		if(_ts_diff(&port->drain.until, &now) <= 0)
+		{
+			return 0;
+		}
+
+		unsigned short status = 0;
+
+		port->usb.ctrl++;
+		if(ftdi_poll_modem_status(&port->ftdi, &status) != 0)
+		{
+			return 1;
+		}
+
+		if(status & FTDI_TEMT)
+		{
+			return 0;
+		}
+
+		_hold(8 * 44); // eight slots, bounds control transfers while waiting
+	}
+}
+
+static int
+_ftdi_flush(port_t *port)
+{
+#if defined(HAVE_LIBFTDI1)
+	if(!port->async.tc)
+	{
+		return 0;
+	}
+
+	// wait for completion of frame in flight
+	const int res = ftdi_transfer_data_done(port->async.tc);
+	port->async.tc = NULL;
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	hist_add(&port->stat[STAT_FLIGHT], _ts_lapse(&now, &port->async.submit));
+
+	if(res != port->async.len)
+	{
+		syslog(LOG_ERR, "[%s] transfer incomplete (%i/%i)", __func__,
+			res, port->async.len);
+		return 1;
+	}
+
+	_ftdi_drain_arm(port, res);
+#else
+	(void)port;
+#endif
+
+	return 0;
+}
+
+static int
+_ftdi_break_line(app_t *app, port_t *port)
+{
+	// host-timed break via line property, two control transfers
+	port->usb.ctrl++;
+	if(ftdi_set_line_property2(&port->ftdi, BITS_8, STOP_BIT_2, NONE,
+		BREAK_ON) != 0)
+	{
+		return 1;
+	}
+
+	_hold(app->timing.break_us);
+
+	port->usb.ctrl++;
+	if(ftdi_set_line_property2(&port->ftdi, BITS_8, STOP_BIT_2, NONE,
+		BREAK_OFF) != 0)
+	{
+		return 1;
+	}
+
+	_hold(app->timing.mab_us);
+
+	return 0;
+}
+
+static int
+_ftdi_xmit(app_t *app, port_t *port)
+{
+	// break must not start before previous frame has been handed over and
+	// has left the wire
+	if( (_ftdi_flush(port) != 0) || (_ftdi_drain(port) != 0) )
+	{
+		return 1;
+	}
+
+	struct timespec t0;
+	clock_gettime(CLOCK_REALTIME, &t0);
+
+	port->usb.frames++;
+
+	if(_ftdi_break_line(app, port) != 0)
+	{
+		goto failure;
+	}
+
+	struct timespec t1;
+	clock_gettime(CLOCK_REALTIME, &t1);
+	hist_add(&port->stat[STAT_BREAK], _ts_lapse(&t1, &t0));
+
+	port->usb.bulk++;
+
+	const ssize_t sz = sizeof(port->dmx[0].start_code) + port->nslots;
+#if defined(HAVE_LIBFTDI1)
+	if(app->async.enabled)
+	{
+		// hand over frame and continue filling the other buffer meanwhile
+		port->async.tc = ftdi_write_data_submit(&port->ftdi,
+			port->dmx[port->cur].start_code, sz);
+		if(!port->async.tc)
+		{
+			goto failure;
+		}
+
+		clock_gettime(CLOCK_REALTIME, &port->async.submit);
+		port->async.len = sz;
+		port->cur ^= 1;
+
+		return 0;
+	}
+#endif
+	if(ftdi_write_data(&port->ftdi, port->dmx[port->cur].start_code, sz) != sz)
+	{
+		goto failure;
+	}
+
+	_ftdi_drain_arm(port, sz);
+
+	return 0;
+
+failure:
+	syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+	return 1;
+}
+
+static bool
+_port_fail(app_t *app, port_t *port)
+{
+	syslog(LOG_ERR, "[%s] universe %"PRIu16" adapter failed, taking it offline",
+		__func__, port->universe);
+
+	atomic_store(&port->offline, true);
+	atomic_store(&port->quiesced, true); // called by owning thread only
+
+	// adapter is reopened in the background with auto-reconnect
+	if(atomic_load(&reconnect))
+	{
+		return false;
+	}
+
+	// keep the remaining adapters going, tear down once all have failed
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		if(!atomic_load(&app->ports[i].offline))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int
+_ftdi_selftest(app_t *app, port_t *port)
+{
+	unsigned char latency_ms = 0;
+	unsigned int chunksize = 0;
+
+	if(  (ftdi_get_latency_timer(&port->ftdi, &latency_ms) != 0)
+		|| (ftdi_write_data_get_chunksize(&port->ftdi, &chunksize) != 0) )
+	{
+		return 1;
+	}
+
+	// time a couple of complete frames with the resulting settings
+	hist_t hist;
+	hist_clear(&hist);
+
+	for(uint32_t i = 0; i < SELFTEST_FRAMES; i++)
+	{
+		struct timespec t0;
+		clock_gettime(CLOCK_REALTIME, &t0);
+
+		if( (_ftdi_xmit(app, port) != 0) || (_ftdi_flush(port) != 0) )
+		{
+			return 1;
+		}
+
+		struct timespec t1;
+		clock_gettime(CLOCK_REALTIME, &t1);
+		hist_add(&hist, _ts_lapse(&t1, &t0));
+	}
+
+	syslog(LOG_INFO, "[%s] universe %"PRIu16" latency timer: %u ms chunksize: %u bytes",
+		__func__, port->universe, latency_ms, chunksize);
+	syslog(LOG_INFO, "[%s] universe %"PRIu16" frame write latency min: %.3f ms max: %.3f ms",
+		__func__, port->universe, hist.min / 1e6, hist.max / 1e6);
+
+	return 0;
+}
+
+static int
+_ftdi_open(app_t *app, port_t *port, int baud, enum ftdi_stopbits_type sbit,
+	enum ftdi_break_type brk)
+{
+	port->ftdi.module_detach_mode = AUTO_DETACH_SIO_MODULE;
+
+	if(ftdi_init(&port->ftdi) != 0)
+	{
+		goto failure;
+	}
+
+	// without workers, adapters share the output thread, so a stalled one must
+	// not block its siblings for the default 5 s, but about two frames on the
+	// wire plus latency timer
+	const int timeout_ms = 2 * (PRO_OVERHEAD + 1 + 512) * 11 * 1000 / baud
+		+ (app->usb_cfg.latency_ms ? app->usb_cfg.latency_ms : 16); // chip default
+
+	port->ftdi.usb_read_timeout = timeout_ms;
+	port->ftdi.usb_write_timeout = timeout_ms;
+
+	if(ftdi_set_interface(&port->ftdi, INTERFACE_ANY) != 0)
+	{
+		goto failure_deinit;
+	}
+
+	if(port->des || port->sid)
+	{
+		if(ftdi_usb_open_desc(&port->ftdi, app->vid, app->pid,
+			port->des, port->sid) != 0)
+		{
+			goto failure_deinit;
+		}
+	}
+	else
+	{
+		if(ftdi_usb_open(&port->ftdi, app->vid, app->pid) != 0)
+		{
+			goto failure_deinit;
+		}
+	}
+
+#if defined(HAVE_LIBUSB)
+	// remember position on the bus to recognize detachment
+	libusb_device *dev = libusb_get_device(port->ftdi.usb_dev);
+	port->hotplug.bus = libusb_get_bus_number(dev);
+	port->hotplug.addr = libusb_get_device_address(dev);
+#endif
+
+	if(ftdi_usb_reset(&port->ftdi) != 0)
+	{
+		goto failure_close;
+	}
+
+	if(ftdi_set_baudrate(&port->ftdi, baud) != 0)
+	{
+		goto failure_close;
+	}
+
+	if(ftdi_set_line_property2(&port->ftdi, BITS_8, sbit, NONE, brk) != 0)
+	{
+		goto failure_close;
+	}
+
+	if(ftdi_usb_purge_buffers(&port->ftdi) != 0)
+	{
+		goto failure_close;
+	}
+
+	if(ftdi_setflowctrl(&port->ftdi, SIO_DISABLE_FLOW_CTRL) != 0)
+	{
+		goto failure_close;
+	}
+
+	if(ftdi_setrts(&port->ftdi, 0) != 0)
+	{
+		goto failure_close;
+	}
+
+	if(app->usb_cfg.latency_ms
+		&& (ftdi_set_latency_timer(&port->ftdi, app->usb_cfg.latency_ms) != 0) )
+	{
+		goto failure_close;
+	}
+
+	if(app->usb_cfg.chunksize
+		&& (ftdi_write_data_set_chunksize(&port->ftdi, app->usb_cfg.chunksize) != 0) )
+	{
+		goto failure_close;
+	}
+
+	return 0;
+
+failure_close:
+	ftdi_usb_close(&port->ftdi);
+
+failure_deinit:
+	ftdi_deinit(&port->ftdi);
+
+failure:
+	syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+	return -1;
+}
+
+static int
+_ftdi_port_init(app_t *app, port_t *port)
+{
+	port->drain.pending = false;
+
+	return _ftdi_open(app, port, DMX_BAUD, STOP_BIT_2, BREAK_ON);
+}
+
+static void
+_ftdi_port_deinit(port_t *port)
+{
+	_ftdi_flush(port);
+
+	if(ftdi_usb_close(&port->ftdi) != 0)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+	}
+
+	ftdi_deinit(&port->ftdi);
+}
+
+static int
+_tty_open(app_t *app, port_t *port, uint32_t baud, uint32_t stop_bits)
+{
+	// n-th comma-separated device for n-th adapter
+	const char *path = app->sink.path;
+
+	for(uint32_t i = port - app->ports; i > 0; i--)
+	{
+		path = strchr(path, ',');
+		if(!path)
+		{
+			syslog(LOG_ERR, "[%s] no device for universe %"PRIu16, __func__,
+				port->universe);
+			return -1;
+		}
+
+		path++;
+	}
+
+	char dev [PATH_MAX];
+	snprintf(dev, sizeof(dev), "%.*s", (int)strcspn(path, ","), path);
+
+	// kernel ftdi_sio driver instead of libusb
+	port->sink.fd = open(dev, O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if(port->sink.fd == -1)
+	{
+		goto failure;
+	}
+
+	if(tty_setup(port->sink.fd, baud, stop_bits) != 0)
+	{
+		close(port->sink.fd);
+		goto failure;
+	}
+
+	port->sink.slave = -1;
+
+	syslog(LOG_INFO, "[%s] universe %"PRIu16" on %s", __func__,
+		port->universe, dev);
+
+	return 0;
+
+failure:
+	syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+	return -1;
+}
+
+static int
+_tty_init(app_t *app, port_t *port)
+{
+	return _tty_open(app, port, DMX_BAUD, 2);
+}
+
+static int
+_tty_xmit(app_t *app, port_t *port)
+{
+	// break must not start before previous frame has left the wire
+	if(tcdrain(port->sink.fd) != 0)
+	{
+		goto failure;
+	}
+
+	struct timespec t0;
+	clock_gettime(CLOCK_REALTIME, &t0);
+
+	port->usb.frames++;
+
+	// tcsendbreak only knows breaks of 250 ms and more
+	port->usb.ctrl++;
+	if(ioctl(port->sink.fd, TIOCSBRK) != 0)
+	{
+		goto failure;
+	}
+
+	_hold(app->timing.break_us);
+
+	port->usb.ctrl++;
+	if(ioctl(port->sink.fd, TIOCCBRK) != 0)
+	{
+		goto failure;
+	}
+
+	_hold(app->timing.mab_us);
+
+	struct timespec t1;
+	clock_gettime(CLOCK_REALTIME, &t1);
+	hist_add(&port->stat[STAT_BREAK], _ts_lapse(&t1, &t0));
+
+	port->usb.bulk++;
+
+	const ssize_t sz = sizeof(port->dmx[0].start_code) + port->nslots;
+	if(write(port->sink.fd, port->dmx[port->cur].start_code, sz) != sz)
+	{
+		goto failure;
+	}
+
+	return 0;
+
+failure:
+	syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+	return 1;
+}
+
+static int
+_null_init(app_t *app __attribute__((unused)),
+	port_t *port __attribute__((unused)))
+{
+	return 0;
+}
+
+static void
+_null_deinit(port_t *port __attribute__((unused)))
+{
+	// nothing to do
+}
+
+static int
+_null_xmit(app_t *app __attribute__((unused)), port_t *port)
+{
+	port->usb.frames++;
+
+	return 0;
+}
+
+static int
+_file_init(app_t *app, port_t *port)
+{
+	// frames of all adapters are appended to the same log
+	port->sink.fd = open(app->sink.path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+		0644);
+	if(port->sink.fd == -1)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		return -1;
+	}
+
+	port->sink.slave = -1;
+
+	return 0;
+}
+
+static int
+_pty_init(app_t *app __attribute__((unused)), port_t *port)
+{
+	port->sink.fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if(port->sink.fd == -1)
+	{
+		goto failure;
+	}
+
+	if( (grantpt(port->sink.fd) != 0) || (unlockpt(port->sink.fd) != 0) )
+	{
+		goto failure_close;
+	}
+
+	const char *name = ptsname(port->sink.fd);
+	if(!name)
+	{
+		goto failure_close;
+	}
+
+	// keep slave end open in raw mode, so frames pass unaltered and do not get lost
+	port->sink.slave = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if(port->sink.slave == -1)
+	{
+		goto failure_close;
+	}
+
+	struct termios tio;
+	if(tcgetattr(port->sink.slave, &tio) != 0)
+	{
+		goto failure_slave;
+	}
+
+	cfmakeraw(&tio);
+
+	if(tcsetattr(port->sink.slave, TCSANOW, &tio) != 0)
+	{
+		goto failure_slave;
+	}
+
+	syslog(LOG_NOTICE, "[%s] universe %"PRIu16" on %s", __func__,
+		port->universe, name);
+
+	return 0;
+
+failure_slave:
+	close(port->sink.slave);
+
+failure_close:
+	close(port->sink.fd);
+
+failure:
+	syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+	return -1;
+}
+
+static void
+_sink_deinit(port_t *port)
+{
+	if(port->sink.slave != -1)
+	{
+		close(port->sink.slave);
+	}
+
+	close(port->sink.fd);
+}
+
+static int
+_sink_xmit(app_t *app __attribute__((unused)), port_t *port)
+{
+	const size_t sz = sizeof(port->dmx[0].start_code) + port->nslots;
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	const record_t rec = {
+		.timestamp = (uint64_t)now.tv_sec * NSECS + now.tv_nsec,
+		.universe = port->universe,
+		.size = sz
+	};
+
+	const struct iovec iov [2] = {
+		{ .iov_base = (void *)&rec, .iov_len = sizeof(rec) },
+		{ .iov_base = port->dmx[port->cur].start_code, .iov_len = sz }
+	};
+
+	port->usb.frames++;
+
+	// nobody reading from pty, drop new frames while the queue is full, as
+	// flushing it would cut a record a slow reader has only partially read
+	int queued;
+	if(  (port->sink.slave != -1)
+		&& (ioctl(port->sink.slave, FIONREAD, &queued) == 0)
+		&& (queued + sizeof(rec) + sz >= PTY_QUEUE) )
+	{
+		return 0; // drop frame
+	}
+
+	// one record per call, so records of several adapters do not interleave
+	const ssize_t written = writev(port->sink.fd, iov, 2);
+	if(written == -1)
+	{
+		if(errno == EAGAIN)
+		{
+			return 0; // drop frame
+		}
+
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		return 1;
+	}
+
+	if(written != (ssize_t)(sizeof(rec) + sz))
+	{
+		syslog(LOG_WARNING, "[%s] short write (%zd/%zu), frame dropped", __func__,
+			written, sizeof(rec) + sz);
+	}
+
+	return 0;
+}
+
+static int
+_pro_init(app_t *app, port_t *port)
+{
+	// optional serial device, e.g. to talk to an emulator on a pty, at the
+	// same 8N1 link settings as via libftdi
+	if(app->sink.path)
+	{
+		return _tty_open(app, port, PRO_BAUD, 1);
+	}
+
+	// device generates break and mark-after-break itself
+	port->sink.fd = -1;
+
+	return _ftdi_open(app, port, PRO_BAUD, STOP_BIT_1, BREAK_OFF);
+}
+
+static void
+_pro_deinit(port_t *port)
+{
+	if(port->sink.fd != -1)
+	{
+		_sink_deinit(port);
+		return;
+	}
+
+	_ftdi_port_deinit(port);
+}
+
+static int
+_pro_xmit(app_t *app __attribute__((unused)), port_t *port)
+{
+	const int sz = pro_pack(port->pro.buf, PRO_LABEL_DMX,
+		port->dmx[port->cur].start_code,
+		sizeof(port->dmx[0].start_code) + port->nslots);
+
+	// a single bulk transfer per frame, no control transfers
+	port->usb.frames++;
+	port->usb.bulk++;
+
+	const int res = (port->sink.fd != -1)
+		? write(port->sink.fd, port->pro.buf, sz)
+		: ftdi_write_data(&port->ftdi, port->pro.buf, sz);
+	if(res != sz)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		return 1;
+	}
+
+	return 0;
+}
+
+static const backend_t backends [] = {
+	{
+		.name = "ftdi",
+		.usb = true,
+		.init = _ftdi_port_init,
+		.deinit = _ftdi_port_deinit,
+		.xmit = _ftdi_xmit,
+		.selftest = _ftdi_selftest
+	},
+	{
+		.name = "tty",
+		.path = true,
+		.init = _tty_init,
+		.deinit = _sink_deinit,
+		.xmit = _tty_xmit
+	},
+	{
+		.name = "pro",
+		.usb = true,
+		.init = _pro_init,
+		.deinit = _pro_deinit,
+		.xmit = _pro_xmit
+	},
+	{
+		.name = "null",
+		.init = _null_init,
+		.deinit = _null_deinit,
+		.xmit = _null_xmit
+	},
+	{
+		.name = "file",
+		.path = true,
+		.init = _file_init,
+		.deinit = _sink_deinit,
+		.xmit = _sink_xmit
+	},
+	{
+		.name = "pty",
+		.init = _pty_init,
+		.deinit = _sink_deinit,
+		.xmit = _sink_xmit
+	},
+	{
+		.name = NULL
+	}
+};
+
+static int
+_port_open(app_t *app, port_t *port)
+{
+	if(app->backend->init(app, port) != 0)
+	{
+		return -1;
+	}
+
+	port->open = true;
+
+	return 0;
+}
+
+static void
+_port_close(app_t *app, port_t *port)
+{
+	if(!port->open)
+	{
+		return;
+	}
+
+	port->open = false;
+	app->backend->deinit(port);
+}
+
+static int
+_output_init(app_t *app)
+{
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		port_t *port = &app->ports[i];
+
+		port->backoff.ms = 0;
+		port->backoff.parked = false;
+
+		if(_port_open(app, port) == 0)
+		{
+			// opt-in, once per adapter, not again upon restart or reconnect
+			const bool selftest = app->usb_cfg.selftest && app->backend->selftest
+				&& !port->tested;
+
+			if(!selftest || (app->backend->selftest(app, port) == 0) )
+			{
+				port->tested |= selftest;
+				atomic_store(&port->quiesced, false);
+				atomic_store(&port->offline, false);
+				continue;
+			}
+
+			_port_close(app, port);
+		}
+
+		// with auto-reconnect, keep going and reopen adapter in the background
+		if(atomic_load(&reconnect))
+		{
+			syslog(LOG_WARNING, "[%s] universe %"PRIu16" adapter not available, retrying",
+				__func__, port->universe);
+			atomic_store(&port->offline, true);
+			atomic_store(&port->quiesced, true); // no output thread running yet
+			clock_gettime(CLOCK_MONOTONIC, &port->backoff.next);
+			continue;
+		}
+
+		while(i--)
+		{
+			_port_close(app, &app->ports[i]);
+		}
+
+		return -1;
+	}
+
+	return 0;
+}
+
+static bool
+_output_recover(app_t *app)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	bool recovered = false;
+
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		port_t *port = &app->ports[i];
+
+		// context may only be touched once owning thread has let go of it
+		if(  !atomic_load(&port->offline) || !atomic_load(&port->quiesced)
+			|| port->backoff.parked || (_ts_diff(&port->backoff.next, &now) > 0) )
+		{
+			continue;
+		}
+
+		// only reopen the output side, OSC, state and scheduler keep running
+		_port_close(app, port);
+
+		if(_port_open(app, port) != 0)
+		{
+			port->backoff.ms = port->backoff.ms
+				? port->backoff.ms * 2
+				: BACKOFF_MIN_MS;
+
+			if(port->backoff.ms > BACKOFF_MAX_MS)
+			{
+				port->backoff.ms = BACKOFF_MAX_MS;
+			}
+
+			port->backoff.next = now;
+			_ts_add(&port->backoff.next, (int64_t)port->backoff.ms * 1000000);
+
+			syslog(LOG_NOTICE, "[%s] universe %"PRIu16" reconnect failed, retrying in %"PRIu32" ms",
+				__func__, port->universe, port->backoff.ms);
+			continue;
+		}
+
+		syslog(LOG_NOTICE, "[%s] universe %"PRIu16" reconnected", __func__,
+			port->universe);
+
+		port->backoff.ms = 0;
+		atomic_store(&port->quiesced, false);
+		atomic_store(&port->offline, false);
+		recovered = true;
+	}
+
+	return recovered;
+}
+
+static void
+_output_deinit(app_t *app)
+{
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		_port_close(app, &app->ports[i]);
+	}
+}
+
+static void
+_osc_deinit(app_t *app)
+{
+	for(uint32_t i = 0; i < app->ninputs; i++)
+	{
+		input_t *input = &app->inputs[i];
+
+		lv2_osc_stream_deinit(&input->stream);
+
+		if(input->wake >= 0)
+		{
+			close(input->wake);
+			input->wake = -1;
+		}
+
+		if(input->rb.rx)
+		{
+			varchunk_free(input->rb.rx);
+			input->rb.rx = NULL;
+		}
+
+		if(input->rb.tx)
+		{
+			varchunk_free(input->rb.tx);
+			input->rb.tx = NULL;
+		}
+	}
+}
+
+static int
+_patch_universe(app_t *app, uint16_t universe)
+{
+	for(uint32_t k = 0; k < app->patch.nuniv; k++)
+	{
+		if(app->patch.univ[k] == universe)
+		{
+			return k;
+		}
+	}
+
+	if(app->patch.nuniv >= PATCH_UNIVERSES)
+	{
+		return -1;
+	}
+
+	// make logical universe visible to patterns right away
+	if(!state_universe(&app->state, universe, true))
+	{
+		return -1;
+	}
+
+	app->patch.univ[app->patch.nuniv] = universe;
+
+	return app->patch.nuniv++;
+}
+
+static int
+_patch_load(app_t *app, const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if(!file)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		return -1;
+	}
+
+	// unpatched slots point to the trailing zero byte
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		gather_clear(&app->ports[i].gather, PATCH_UNIVERSES*512);
+	}
+
+	char *line = NULL;
+	size_t size = 0;
+	uint32_t nline = 0;
+	uint32_t npatched = 0;
+
+	while(getline(&line, &size, file) != -1)
+	{
+		patch_t patch;
+
+		nline++;
+
+		const int res = patch_parse(line, &patch);
+		if(res == 0)
+		{
+			continue; // empty line
+		}
+
+		if(res == -1)
+		{
+			syslog(LOG_ERR, "[%s] %s:%"PRIu32": invalid patch", __func__, path, nline);
+			goto failure;
+		}
+
+		const int k = _patch_universe(app, patch.lu);
+		if(k == -1)
+		{
+			syslog(LOG_ERR, "[%s] %s:%"PRIu32": too many logical universes, maximum is %i",
+				__func__, path, nline, PATCH_UNIVERSES);
+			goto failure;
+		}
+
+		bool found = false;
+		for(uint32_t i = 0; i < app->nports; i++)
+		{
+			port_t *port = &app->ports[i];
+
+			if(port->universe != patch.pu)
+			{
+				continue;
+			}
+
+			for(unsigned j = 0; j < patch.num; j++)
+			{
+				gather_set(&port->gather, patch.ps + j, k*512 + patch.lc + j);
+			}
+
+			port->patched = true;
+			found = true;
+		}
+
+		if(!found)
+		{
+			syslog(LOG_WARNING, "[%s] %s:%"PRIu32": universe %u not output by any adapter",
+				__func__, path, nline, patch.pu);
+			continue;
+		}
+
+		npatched += patch.num;
+	}
+
+	free(line);
+	fclose(file);
+
+	syslog(LOG_INFO, "[%s] patched %"PRIu32" slots from %"PRIu32" logical universes",
+		__func__, npatched, app->patch.nuniv);
+
+	return 0;
+
+failure:
+	free(line);
+	fclose(file);
+
+	return -1;
+}
+
+static int
+_osc_init(app_t *app)
+{
+	const LV2_OSC_Driver *driv = app->single
+		? &driver_direct
+		: &driver;
+
+	for(uint32_t i = 0; i < app->ninputs; i++)
+	{
+		input_t *input = &app->inputs[i];
+
+		input->app = app;
+		input->stream.sock = -1;
+		input->wake = -1;
+
+		for(uint32_t j = 0; j < LV2_OSC_STREAM_CLIENTS; j++)
+		{
+			input->stream.clients[j].fd = -1;
+			input->fds[j] = -1;
+		}
+	}
+
+	for(uint32_t i = 0; i < app->ninputs; i++)
+	{
+		input_t *input = &app->inputs[i];
+
+		input->rb.rx = varchunk_new(8192, true);
+		if(!input->rb.rx)
+		{
+			goto failure;
+		}
+
+		input->rb.tx = varchunk_new(8192, true);
+		if(!input->rb.tx)
+		{
+			goto failure;
+		}
+
+		input->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if(input->wake == -1)
+		{
+			syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+			goto failure;
+		}
+
+		// several inputs share the port of the URI
+		const int ret = (app->ninputs > 1)
+			? lv2_osc_stream_init_reuseport(&input->stream, app->url, driv, input)
+			: lv2_osc_stream_init(&input->stream, app->url, driv, input);
+
+		if(ret != 0)
+		{
+			syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+			goto failure;
+		}
+
+		if( (app->ninputs > 1) && !input->stream.server)
+		{
+			syslog(LOG_ERR, "[%s] multiple inputs need an OSC server URI", __func__);
+			goto failure;
+		}
+	}
+
+	app->reply = &app->inputs[0];
+
+	return 0;
+
+failure:
+	_osc_deinit(app);
+	return -1;
+}
+
+static void
+_thread_priority(int priority)
+{
+		if(priority == 0)
+		{
+			return;
+		}
+
+		const struct sched_param schedp = {
+			.sched_priority = priority
+		};
+
+		const pthread_t self = pthread_self();
+
+		if(pthread_setschedparam(self, SCHED_FIFO, &schedp) != 0)
+		{
+			syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		}
+}
+
+static void
+_spin_calibrate(app_t *app, uint64_t step_ns)
+{
+	// cover 99.9% of the sleep lateness observed since the last calibration,
+	// but never spin for more than half a frame
+	uint64_t margin_ns = hist_quantile(&app->spin.window, 0.999);
+
+	hist_clear(&app->spin.window);
+
+	if(margin_ns > step_ns / 2)
+	{
+		margin_ns = step_ns / 2;
+	}
+
+	if(margin_ns != app->spin.margin_ns)
+	{
+		syslog(LOG_DEBUG, "[%s] spin margin: %"PRIu64" ns", __func__, margin_ns);
+
+		app->spin.margin_ns = margin_ns;
+	}
+}
+
+static void
+_thread_affinity(int cpu)
+{
+	if(cpu < 0)
+	{
+		return;
+	}
+
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	CPU_SET(cpu, &cpuset);
+
+	const pthread_t self = pthread_self();
+
+	const int err = pthread_setaffinity_np(self, sizeof(cpu_set_t), &cpuset);
+	if(err != 0)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(err));
+	}
+}
+
+static void
+_prefault(void *ptr, size_t len)
+{
+	volatile uint8_t *buf = ptr;
+	const size_t pagesize = sysconf(_SC_PAGESIZE);
+
+	// touch every page without altering its content
+	for(size_t i = 0; i < len; i += pagesize)
+	{
+		buf[i] = buf[i];
+	}
+}
+
+static void
+_thread_prefault(app_t *app)
+{
+	if(!app->prefault)
+	{
+		return;
+	}
+
+	volatile uint8_t stack [PREFAULT_STACK];
+	const size_t pagesize = sysconf(_SC_PAGESIZE);
+
+	// touch every page via volatile stores, a memset of the dead local array
+	// would be optimized away
+	for(size_t i = 0; i < sizeof(stack); i += pagesize)
+	{
+		stack[i] = 0x0;
+	}
+}
+
+static int
+_mem_lock(void)
+{
+	if(mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		return -1;
+	}
+
+	// never give heap memory back to the system nor use mmap for it, so that
+	// scheduled packets are allocated from prefaulted memory
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+
+	uint8_t *heap = malloc(PREFAULT_HEAP);
+	if(!heap)
+	{
+		syslog(LOG_ERR, "[%s] malloc failed", __func__);
+		return -1;
+	}
+
+	memset(heap, 0x0, PREFAULT_HEAP);
+	free(heap);
+
+	return 0;
+}
+
+static void
+_mem_prefault(app_t *app)
+{
+	if(!app->prefault)
+	{
+		return;
+	}
+
+	_prefault(app, sizeof(app_t));
+
+	for(uint32_t i = 0; i < app->ninputs; i++)
+	{
+		const input_t *input = &app->inputs[i];
+
+		_prefault(input->rb.rx, sizeof(varchunk_t) + input->rb.rx->size);
+		_prefault(input->rb.tx, sizeof(varchunk_t) + input->rb.tx->size);
+
+#if defined(LV2_OSC_STREAM_HAS_MMSG)
+		if(input->stream.mmsg_buf)
+		{
+			_prefault(input->stream.mmsg_buf,
+				LV2_OSC_STREAM_MMSG * LV2_OSC_STREAM_MMSG_SIZE);
+		}
+#endif
+	}
+}
+
+static int
+_frame(app_t *app, const struct timespec *to, const struct timespec *t0,
+	bool force)
+{
+	state_t *state = &app->state;
+	int ret = 0;
+
+	// read OSC messages from ringbuffers of all inputs
+	for(uint32_t i = 0; i < app->ninputs; i++)
+	{
+		input_t *input = &app->inputs[i];
+		const uint8_t *buf;
+		size_t len;
+
+		app->reply = input;
+
+		while( (buf = _rb_read_req(input->rb.rx, &app->reply_to, &len)) )
+		{
+			_handle_osc_packet(app, LV2_OSC_IMMEDIATE, buf, len);
+
+			varchunk_read_advance(input->rb.rx);
+		}
+	}
+
+	// read OSC messages from list
+	for(sched_t *elmnt = app->list; elmnt; elmnt = app->list)
+	{
+		double diff = to->tv_sec - elmnt->to.tv_sec;
+		diff += (to->tv_nsec - elmnt->to.tv_nsec) * 1e-9;
+
+		if(diff < 0.0)
+		{
+			break;
+		}
+
+		app->reply = elmnt->input;
+		app->reply_to = elmnt->reply_to;
+		_handle_osc_packet(app, LV2_OSC_IMMEDIATE, elmnt->buf, elmnt->len);
+
+		app->list = elmnt->next;
+		free(elmnt);
+	}
+
+	// resolve logical universes of patch table
+	for(uint32_t k = 0; k < app->patch.nuniv; k++)
+	{
+		state_resolve(state, app->patch.univ[k], &app->patch.buf[k*512]);
+	}
+
+	// fill dmx buffers, or publish them to the output workers
+	const uint8_t *resolved [MAX_PORTS];
+	uint32_t nresolved [MAX_PORTS];
+
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		port_t *port = &app->ports[i];
+		frame_t *frame = app->workers
+			? &port->tb.buf[port->tb.back]
+			: NULL;
+		uint8_t *data = frame
+			? frame->data
+			: port->dmx[port->cur].data;
+
+		uint32_t nactive;
+		if(port->mirror)
+		{
+			// universe has already been resolved for the first adapter outputting it
+			const uint32_t j = port->mirror - app->ports;
+
+			memcpy(data, resolved[j], 512);
+			nactive = nresolved[j];
+		}
+		else if(port->patched)
+		{
+			gather_run(&port->gather, app->patch.buf, data);
+			nactive = port->gather.nslots;
+		}
+		else
+		{
+			nactive = state_resolve(state, port->universe, data);
+		}
+
+		resolved[i] = data;
+		nresolved[i] = nactive;
+
+		const uint32_t nslots = app->slots
+			? app->slots
+			: (nactive > DMX_MIN_SLOTS ? nactive : DMX_MIN_SLOTS);
+
+		if(frame)
+		{
+			frame->nslots = nslots;
+			port->tb.back = atomic_exchange_explicit(&port->tb.latest,
+				port->tb.back | TB_FRESH, memory_order_acq_rel) & TB_INDEX;
+		}
+		else
+		{
+			port->nslots = nslots;
+		}
+	}
+
+	struct timespec t1;
+	clock_gettime(CLOCK_REALTIME, &t1);
+	hist_add(&app->stat[STAT_DISPATCH], _ts_lapse(&t1, t0));
+
+	if(app->workers)
+	{
+		_stat_rate_update(app, &t1);
+		goto skip;
+	}
+
+	// skip unchanged frames until keep-alive refresh is due
+	uint32_t nxmit = 0;
+
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		port_t *port = &app->ports[i];
+
+		if(atomic_load(&port->offline))
+		{
+			atomic_store(&port->quiesced, true); // hand context over to recovery
+			port->stale = true; // send current look right after reconnect
+			continue;
+		}
+
+		if(app->adaptive.enabled)
+		{
+			if(!force && !port->stale && (memcmp(port->prev,
+				port->dmx[port->cur].data, sizeof(port->prev)) == 0) )
+			{
+				continue;
+			}
+
+			memcpy(port->prev, port->dmx[port->cur].data, sizeof(port->prev));
+			port->stale = false;
+		}
+
+		// write DMX data, publish statistics before a failure hands it over
+		const int res = app->backend->xmit(app, port);
+		_stat_publish(port);
+
+		if( (res != 0) && _port_fail(app, port) )
+		{
+			ret = -1;
+		}
+
+		nxmit++;
+	}
+
+	if(app->adaptive.enabled)
+	{
+		app->adaptive.pending = false;
+
+		if(nxmit == 0)
+		{
+			// with all adapters offline, a due refresh counts as done, or its
+			// deadline would stay in the past and the loop would spin
+			if(force)
+			{
+				app->adaptive.last = *t0;
+			}
+
+			ret = 1;
+			goto skip;
+		}
+
+		app->adaptive.last = *t0;
+	}
+
+	struct timespec t2;
+	clock_gettime(CLOCK_REALTIME, &t2);
+	hist_add(&app->stat[STAT_XMIT], _ts_lapse(&t2, &t1));
+	_stat_rate_update(app, &t2);
+
+skip:
+	// dump statistics upon SIGUSR1
+	if(atomic_exchange(&dump, false))
+	{
+		_stat_dump(app);
+	}
+
+	return ret;
+}
+
+static bool
+_step_update(app_t *app)
+{
+	if(!app->max_rate || app->workers)
+	{
+		return false;
+	}
+
+	// pace back-to-back frames by the longest actual frame
+	uint32_t nslots = DMX_MIN_SLOTS;
+
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		if(app->ports[i].nslots > nslots)
+		{
+			nslots = app->ports[i].nslots;
+		}
+	}
+
+	const uint64_t step_ns = dmx_frame_ns(app->timing.break_us,
+		app->timing.mab_us, sizeof(app->ports[0].dmx[0].start_code) + nslots);
+
+	if(step_ns == app->step_ns)
+	{
+		return false;
+	}
+
+	app->step_ns = step_ns;
+
+	return true;
+}
+
+static void *
+_beat(void *data)
+{
+	app_t *app = data;
+
+	_thread_priority(app->priority.out);
+	_thread_affinity(app->affinity.out);
+	_thread_prefault(app);
+
+	struct timespec to;
+	clock_gettime(CLOCK_REALTIME, &to);
+
+	while(!atomic_load(&done))
+	{
+		// sleep until next beat timestamp, minus spin margin
+		struct timespec wake = to;
+
+		if(app->spin.enabled)
+		{
+			_ts_add(&wake, -(int64_t)app->spin.margin_ns);
+		}
+
+		if(clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &wake, NULL) != 0)
+		{
+			continue;
+		}
+
+		struct timespec t0;
+		clock_gettime(CLOCK_REALTIME, &t0);
+		const uint64_t late_ns = _ts_lapse(&t0, &wake);
+		hist_add(&app->stat[STAT_SLEEP], late_ns);
+
+		if(app->spin.calibrate)
+		{
+			hist_add(&app->spin.window, late_ns);
+		}
+
+		// spin until exact beat timestamp
+		if(app->spin.enabled)
+		{
+			while(_ts_diff(&to, &t0) > 0)
+			{
+				clock_gettime(CLOCK_REALTIME, &t0);
+			}
+		}
+
+		hist_add(&app->stat[STAT_WAKEUP], _ts_lapse(&t0, &to));
+
+		if(_frame(app, &to, &t0, true) == -1)
+		{
+			_quit(); // end xmit loop
+		}
+
+		_step_update(app);
+
+		// recalibrate spin margin once per second
+		if(app->spin.calibrate && (app->spin.window.count >= app->fps) )
+		{
+			_spin_calibrate(app, app->step_ns);
+		}
+
+		// calculate next beat timestamp
+		_ts_add(&to, app->step_ns);
+
+		// back-to-back frames are paced by the drained wire, restart frame clock
+		// instead of accumulating lag behind it
+		if(app->max_rate)
+		{
+			struct timespec t1;
+			clock_gettime(CLOCK_REALTIME, &t1);
+
+			if(_ts_diff(&t1, &to) > 0)
+			{
+				to = t1;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static void
+_adaptive_deadline(app_t *app, bool pending, struct timespec *deadline)
+{
+	struct timespec earliest = app->adaptive.last;
+	_ts_add(&earliest, app->step_ns);
+
+	// changes go out as soon as the maximum frame rate permits
+	if(pending)
+	{
+		*deadline = earliest;
+		return;
+	}
+
+	// keep-alive refresh
+	*deadline = app->adaptive.last;
+	_ts_add(deadline, NSECS / app->adaptive.fps);
+
+	// wake up earlier for scheduled messages
+	if(app->list && (_ts_diff(&app->list->to, deadline) < 0) )
+	{
+		*deadline = app->list->to;
+
+		if(_ts_diff(&earliest, deadline) > 0)
+		{
+			*deadline = earliest;
+		}
+	}
+}
+
+static void
+_adaptive_init(app_t *app)
+{
+	// first frame is due immediately
+	clock_gettime(CLOCK_REALTIME, &app->adaptive.last);
+	_ts_add(&app->adaptive.last, -(int64_t)(NSECS / app->adaptive.fps));
+}
+
+static inline bool
+_adaptive_refresh(app_t *app, const struct timespec *now)
+{
+	return _ts_diff(now, &app->adaptive.last) >= NSECS / app->adaptive.fps;
+}
+
+static void *
+_worker(void *data)
+{
+	port_t *port = data;
+	app_t *app = port->app;
+	const int idx = port - app->ports;
+
+	// each worker on its own CPU next to the resolving output thread
+	_thread_priority(app->priority.out);
+	_thread_affinity(app->affinity.out >= 0
+		? app->affinity.out + 1 + idx
+		: -1);
+	_thread_prefault(app);
+
+	struct timespec to;
+	clock_gettime(CLOCK_REALTIME, &to);
+	_ts_add(&to, port->phase_ns);
+
+	while(!atomic_load(&done))
+	{
+		if(clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &to, NULL) != 0)
+		{
+			continue;
+		}
+
+		struct timespec t0;
+		clock_gettime(CLOCK_REALTIME, &t0);
+		hist_add(&port->stat[STAT_WAKEUP], _ts_lapse(&t0, &to));
+
+		// pick up most recently resolved frame, if any
+		if(atomic_load_explicit(&port->tb.latest, memory_order_acquire) & TB_FRESH)
+		{
+			port->tb.front = atomic_exchange_explicit(&port->tb.latest,
+				port->tb.front, memory_order_acq_rel) & TB_INDEX;
+		}
+
+		const frame_t *frame = &port->tb.buf[port->tb.front];
+
+		port->nslots = frame->nslots;
+		memcpy(port->dmx[port->cur].data, frame->data, sizeof(frame->data));
+
+		if(atomic_load(&port->offline))
+		{
+			atomic_store(&port->quiesced, true); // hand context over to recovery
+		}
+		else if( (app->backend->xmit(app, port) != 0) && _port_fail(app, port) )
+		{
+			_quit(); // end all xmit loops
+		}
+
+		struct timespec t1;
+		clock_gettime(CLOCK_REALTIME, &t1);
+		hist_add(&port->stat[STAT_XMIT], _ts_lapse(&t1, &t0));
+
+		if(!atomic_load(&port->quiesced))
+		{
+			_stat_publish(port);
+		}
+
+		// calculate next beat timestamp on own frame clock
+		_ts_add(&to, port->max_rate
+			? dmx_frame_ns(app->timing.break_us, app->timing.mab_us,
+				sizeof(port->dmx[0].start_code) + port->nslots)
+			: port->step_ns);
+
+		// back-to-back frames are paced by the drained wire, restart frame clock
+		// instead of accumulating lag behind it
+		if(port->max_rate && (_ts_diff(&t1, &to) > 0) )
+		{
+			to = t1;
+		}
+	}
+
+	return NULL;
+}
+
+static void *
+_beat_adaptive(void *data)
+{
+	app_t *app = data;
+
+	_thread_priority(app->priority.out);
+	_thread_affinity(app->affinity.out);
+	_thread_prefault(app);
+
+	_adaptive_init(app);
+
+	while(!atomic_load(&done))
+	{
+		// sleep until keep-alive refresh, scheduled message or new message
+		struct timespec to;
+		_adaptive_deadline(app, false, &to);
+
+		const bool timeout = sem_timedwait(&app->adaptive.sem, &to) != 0;
+		if(timeout && (errno != ETIMEDOUT) )
+		{
+			continue;
+		}
+
+		while(sem_trywait(&app->adaptive.sem) == 0)
+		{
+			// drain pending wakeups
+		}
+
+		struct timespec t0;
+		clock_gettime(CLOCK_REALTIME, &t0);
+
+		// enforce maximum frame rate
+		bool slept = timeout;
+
+		if(!timeout)
+		{
+			_adaptive_deadline(app, true, &to);
+
+			if(_ts_diff(&to, &t0) > 0)
+			{
+				while(clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &to, NULL) == EINTR)
+				{
+					// try again
+				}
+
+				clock_gettime(CLOCK_REALTIME, &t0);
+				slept = true;
+			}
+		}
+
+		if(slept)
+		{
+			hist_add(&app->stat[STAT_WAKEUP], _ts_lapse(&t0, &to));
+		}
+
+		if(_frame(app, &t0, &t0, _adaptive_refresh(app, &t0)) == -1)
+		{
+			_quit(); // end xmit loop
+		}
+
+		_step_update(app);
+	}
+
+	return NULL;
+}
+
+#if defined(HAVE_LIBUSB)
+static int
+_hotplug_cb(libusb_context *ctx __attribute__((unused)), libusb_device *dev,
+	libusb_hotplug_event event, void *data)
+{
+	app_t *app = data;
+	const uint8_t bus = libusb_get_bus_number(dev);
+	const uint8_t addr = libusb_get_device_address(dev);
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		port_t *port = &app->ports[i];
+
+		if(event == LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT)
+		{
+			if( (port->hotplug.bus != bus) || (port->hotplug.addr != addr) )
+			{
+				continue;
+			}
+
+			// park adapter until it enumerates again
+			syslog(LOG_NOTICE, "[%s] universe %"PRIu16" adapter detached",
+				__func__, port->universe);
+
+			// owning thread may still be inside xmit, recovery waits for it to
+			// acknowledge via quiesced before closing the context
+			port->backoff.parked = true;
+			atomic_store(&port->offline, true);
+		}
+		else if(atomic_load(&port->offline))
+		{
+			// serial ID or description tell whether it is the right one
+			port->backoff.parked = false;
+			port->backoff.ms = 0;
+			port->backoff.next = now;
+		}
+	}
+
+	return 0; // stay registered
+}
+#endif
+
+static void
+_hotplug_init(app_t *app)
+{
+#if defined(HAVE_LIBUSB)
+	app->hotplug.ctx = NULL;
+
+	if(!app->backend->usb)
+	{
+		return;
+	}
+
+	if(!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG))
+	{
+		syslog(LOG_WARNING, "[%s] hotplug not supported, polling instead", __func__);
+		return;
+	}
+
+	int res = libusb_init(&app->hotplug.ctx);
+	if(res != LIBUSB_SUCCESS)
+	{
+		goto failure;
+	}
+
+	res = libusb_hotplug_register_callback(app->hotplug.ctx,
+		LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+		0, app->vid, app->pid, LIBUSB_HOTPLUG_MATCH_ANY,
+		_hotplug_cb, app, &app->hotplug.handle);
+	if(res != LIBUSB_SUCCESS)
+	{
+		libusb_exit(app->hotplug.ctx);
+		app->hotplug.ctx = NULL;
+		goto failure;
+	}
+
+	return;
+
+failure:
+	syslog(LOG_WARNING, "[%s] '%s', polling instead", __func__,
+		libusb_error_name(res));
+#else
+	(void)app;
+#endif
+}
+
+static void
+_hotplug_deinit(app_t *app)
+{
+#if defined(HAVE_LIBUSB)
+	if(app->hotplug.ctx)
+	{
+		libusb_hotplug_deregister_callback(app->hotplug.ctx, app->hotplug.handle);
+		libusb_exit(app->hotplug.ctx);
+		app->hotplug.ctx = NULL;
+	}
+#else
+	(void)app;
+#endif
+}
+
+static void
+_hotplug_run(app_t *app, uint32_t timeout_ms)
+{
+#if defined(HAVE_LIBUSB)
+	if(app->hotplug.ctx)
+	{
+		// hotplug callbacks run from within here
+		struct timeval tv = {
+			.tv_sec = 0,
+			.tv_usec = timeout_ms * 1000
+		};
+
+		libusb_handle_events_timeout_completed(app->hotplug.ctx, &tv, NULL);
+		return;
+	}
+#else
+	(void)app;
+#endif
+
+	if(timeout_ms)
+	{
+		const struct timespec to = {
+			.tv_sec = 0,
+			.tv_nsec = timeout_ms * 1000000
+		};
+
+		clock_nanosleep(CLOCK_MONOTONIC, 0, &to, NULL);
+	}
+}
+
+static void *
+_recover(void *data)
+{
+	app_t *app = data;
+
+	while(!atomic_load(&done))
+	{
+		if(_output_recover(app))
+		{
+			if(app->single)
+			{
+				eventfd_write(app->recover.wake, 1); // wake up event loop
+			}
+			else if(app->adaptive.enabled)
+			{
+				sem_post(&app->adaptive.sem); // wake up output thread
+			}
+		}
+
+		_hotplug_run(app, BACKOFF_MIN_MS);
+	}
+
+	return NULL;
+}
+
+static void
+_recover_init(app_t *app)
+{
+	// reopen failed adapters in the background, USB open and self-test block
+	app->recover.enabled = atomic_load(&reconnect);
+	app->recover.wake = -1;
+
+	if(!app->recover.enabled)
+	{
+		return;
+	}
+
+	if(app->single)
+	{
+		app->recover.wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if(app->recover.wake == -1)
+		{
+			goto failure;
+		}
+	}
+
+	if(pthread_create(&app->recover.thread, NULL, _recover, app) != 0)
+	{
+		goto failure_wake;
+	}
+
+	return;
+
+failure_wake:
+	if(app->recover.wake != -1)
+	{
+		close(app->recover.wake);
+		app->recover.wake = -1;
+	}
+
+failure:
+	syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+	app->recover.enabled = false;
+}
+
+static void
+_recover_deinit(app_t *app)
+{
+	if(!app->recover.enabled)
+	{
+		return;
+	}
+
+	pthread_join(app->recover.thread, NULL);
+
+	if(app->recover.wake != -1)
+	{
+		close(app->recover.wake);
+		app->recover.wake = -1;
+	}
+}
+
+static int
+_epoll_add(int epfd, int fd, uint32_t events)
+{
+	struct epoll_event ev = {
+		.events = events,
+		.data.fd = fd
+	};
+
+	return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static bool
+_input_ready(const input_t *input, int fd)
+{
+	if(fd == input->stream.sock)
+	{
+		return true;
+	}
+
+	for(uint32_t i = 0; i < LV2_OSC_STREAM_CLIENTS; i++)
+	{
+		if( (fd >= 0) && (fd == input->fds[i]) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+_input_run(input_t *input, int epfd)
+{
+	const LV2_OSC_Enum status = lv2_osc_stream_run(&input->stream);
+
+	// a full ringbuffer (ENOMEM) is retried and thus not reported
+	if( (status & LV2_OSC_ERR) && ( (status & LV2_OSC_ERR) != ENOMEM) )
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(status & LV2_OSC_ERR));
+	}
+
+	// watch newly accepted TCP client connections, closed ones have already
+	// left the epoll set by closing them
+	for(uint32_t i = 0; i < LV2_OSC_STREAM_CLIENTS; i++)
+	{
+		const int fd = input->stream.clients[i].fd;
+
+		if(fd == input->fds[i])
+		{
+			continue;
+		}
+
+		input->fds[i] = fd;
+
+		if( (fd >= 0) && (_epoll_add(epfd, fd, EPOLLIN | EPOLLET) != 0) )
+		{
+			syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		}
+	}
+}
+
+#if defined(HAVE_LIBURING)
+static int
+_uring_prep(input_t *input, uring_tag_t tag)
+{
+	struct io_uring_sqe *sqe = io_uring_get_sqe(&input->uring.ring);
+	if(!sqe)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(EBUSY));
+		return -1;
+	}
+
+	switch(tag)
+	{
+		case URING_RECV:
+		{
+			// one request keeps on receiving into buffers picked by the kernel
+			io_uring_prep_recvmsg_multishot(sqe, input->stream.sock,
+				&input->uring.msg, 0);
+			sqe->flags |= IOSQE_BUFFER_SELECT;
+			sqe->buf_group = URING_BGID;
+		} break;
+		case URING_WAKE:
+		{
+			io_uring_prep_poll_multishot(sqe, input->wake, POLLIN);
+		} break;
+		case URING_QUIT:
+		{
+			io_uring_prep_poll_multishot(sqe, quit, POLLIN);
+		} break;
+	}
+
+	io_uring_sqe_set_data64(sqe, tag);
+
+	return 0;
+}
+
+static int
+_uring_init(input_t *input)
+{
+	struct io_uring_params params = {
+		.flags = IORING_SETUP_CQSIZE,
+		.cq_entries = 2*URING_BUFS // never overflows, even with all buffers in flight
+	};
+
+	int ret = io_uring_queue_init_params(URING_ENTRIES, &input->uring.ring, &params);
+	if(ret < 0)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(-ret));
+		return -1;
+	}
+
+	input->uring.bufs = malloc(URING_BUFS * URING_BUF_SIZE);
+	if(!input->uring.bufs)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		goto failure_ring;
+	}
+
+	input->uring.br = io_uring_setup_buf_ring(&input->uring.ring, URING_BUFS,
+		URING_BGID, 0, &ret);
+	if(!input->uring.br)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(-ret));
+		goto failure_bufs;
+	}
+
+	const int mask = io_uring_buf_ring_mask(URING_BUFS);
+
+	for(unsigned i = 0; i < URING_BUFS; i++)
+	{
+		io_uring_buf_ring_add(input->uring.br, &input->uring.bufs[i * URING_BUF_SIZE],
+			URING_BUF_SIZE, i, mask, i);
+	}
+
+	io_uring_buf_ring_advance(input->uring.br, URING_BUFS);
+
+	// multishot receive only takes the name length and lays out each buffer
+	// as struct io_uring_recvmsg_out, peer name and payload
+	memset(&input->uring.msg, 0x0, sizeof(input->uring.msg));
+	input->uring.msg.msg_namelen = sizeof(struct sockaddr_in6);
+
+	if(  (_uring_prep(input, URING_RECV) != 0)
+		|| (_uring_prep(input, URING_WAKE) != 0)
+		|| (_uring_prep(input, URING_QUIT) != 0) )
+	{
+		goto failure_br;
+	}
+
+	ret = io_uring_submit(&input->uring.ring);
+	if(ret < 0)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(-ret));
+		goto failure_br;
+	}
+
+	return 0;
+
+failure_br:
+	io_uring_free_buf_ring(&input->uring.ring, input->uring.br, URING_BUFS,
+		URING_BGID);
+	input->uring.br = NULL;
+
+failure_bufs:
+	free(input->uring.bufs);
+	input->uring.bufs = NULL;
+
+failure_ring:
+	io_uring_queue_exit(&input->uring.ring);
+
+	return -1;
+}
+
+static void
+_uring_deinit(input_t *input)
+{
+	io_uring_free_buf_ring(&input->uring.ring, input->uring.br, URING_BUFS,
+		URING_BGID);
+	input->uring.br = NULL;
+
+	io_uring_queue_exit(&input->uring.ring);
+
+	free(input->uring.bufs);
+	input->uring.bufs = NULL;
+}
+
+static int
+_uring_recv(input_t *input, const struct io_uring_cqe *cqe)
+{
+	const bool more = cqe->flags & IORING_CQE_F_MORE;
+
+	if(cqe->res < 0)
+	{
+		// all buffers are in flight, the datagram waits in the socket
+		if(cqe->res != -ENOBUFS)
+		{
+			return cqe->res;
+		}
+	}
+	else if(cqe->flags & IORING_CQE_F_BUFFER)
+	{
+		const unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+		uint8_t *buf = &input->uring.bufs[bid * URING_BUF_SIZE];
+		struct io_uring_recvmsg_out *out = io_uring_recvmsg_validate(buf,
+			cqe->res, &input->uring.msg);
+
+		if(out && (out->flags & MSG_TRUNC))
+		{
+			syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(EMSGSIZE));
+		}
+		else if(out)
+		{
+			const size_t len = io_uring_recvmsg_payload_length(out, cqe->res,
+				&input->uring.msg);
+
+			if(len > 0)
+			{
+				uint8_t *dst = _write_req(input, len, NULL);
+				if(!dst)
+				{
+					return -EAGAIN; // ringbuffer full, keep completion and buffer
+				}
+
+				memcpy(dst, io_uring_recvmsg_payload(out, &input->uring.msg), len);
+				_write_adv(input, len);
+
+				// replies go to the most recent sender
+				if(out->namelen <= sizeof(input->stream.peer.in6))
+				{
+					input->stream.peer.len = out->namelen;
+					memcpy(&input->stream.peer.in6, io_uring_recvmsg_name(out),
+						out->namelen);
+				}
+			}
+		}
+
+		// hand buffer back to the kernel right away
+		io_uring_buf_ring_add(input->uring.br, buf, URING_BUF_SIZE, bid,
+			io_uring_buf_ring_mask(URING_BUFS), 0);
+		io_uring_buf_ring_advance(input->uring.br, 1);
+	}
+
+	if(!more && (_uring_prep(input, URING_RECV) != 0) )
+	{
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
 static int
-_osc_init(app_t *app)
+_uring_run(input_t *input)
 {
-	app->rb.rx = varchunk_new(8192, true);
-	if(!app->rb.rx)
+	struct io_uring *ring = &input->uring.ring;
+	bool stalled = false;
+
+	while(!atomic_load(&done))
 	{
-		goto failure;
+		int ret;
+
+		if(stalled)
+		{
+			// retry shortly while the ringbuffer is full
+			const struct timespec to = {
+				.tv_sec = 0,
+				.tv_nsec = 1000000 // 1 ms
+			};
+
+			nanosleep(&to, NULL);
+			ret = io_uring_submit(ring);
+		}
+		else
+		{
+			ret = io_uring_submit_and_wait(ring, 1);
+		}
+
+		if( (ret < 0) && (ret != -EINTR) )
+		{
+			syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(-ret));
+			return -1;
+		}
+
+		struct io_uring_cqe *cqe;
+		unsigned head;
+		unsigned seen = 0;
+
+		stalled = false;
+
+		io_uring_for_each_cqe(ring, head, cqe)
+		{
+			const bool more = cqe->flags & IORING_CQE_F_MORE;
+
+			switch(io_uring_cqe_get_data64(cqe))
+			{
+				case URING_RECV:
+				{
+					ret = _uring_recv(input, cqe);
+
+					if(ret == -EAGAIN)
+					{
+						stalled = true;
+					}
+					else if(ret < 0)
+					{
+						syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(-ret));
+						io_uring_cq_advance(ring, seen);
+						return -1;
+					}
+				} break;
+				case URING_WAKE:
+				{
+					eventfd_t val;
+					eventfd_read(input->wake, &val);
+
+					if(!more)
+					{
+						_uring_prep(input, URING_WAKE);
+					}
+				} break;
+				case URING_QUIT:
+				{
+					if(!more)
+					{
+						_uring_prep(input, URING_QUIT);
+					}
+				} break;
+			}
+
+			if(stalled)
+			{
+				break;
+			}
+
+			seen++;
+		}
+
+		io_uring_cq_advance(ring, seen);
+
+		// send pending replies
+		const LV2_OSC_Enum status = lv2_osc_stream_send(&input->stream);
+
+		if(status & LV2_OSC_ERR)
+		{
+			syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(status & LV2_OSC_ERR));
+		}
+	}
+
+	return 0;
+}
+#endif
+
+static void *
+_input(void *data)
+{
+	input_t *input = data;
+	app_t *app = input->app;
+	const int idx = input - app->inputs;
+
+	_thread_priority(app->priority.inp);
+	_thread_affinity(app->affinity.inp >= 0
+		? app->affinity.inp + idx
+		: -1);
+	_thread_prefault(app);
+
+#if defined(HAVE_LIBURING)
+	if(app->uring.enabled)
+	{
+		if(input->stream.socket_type != SOCK_DGRAM)
+		{
+			syslog(LOG_WARNING, "[%s] io_uring receive requires UDP, falling back to epoll",
+				__func__);
+		}
+		else if(_uring_init(input) == 0)
+		{
+			const int ret = _uring_run(input);
+
+			_uring_deinit(input);
+
+			if(ret == 0)
+			{
+				return NULL;
+			}
+
+			syslog(LOG_WARNING, "[%s] io_uring receive failed, falling back to epoll",
+				__func__);
+		}
+		else
+		{
+			syslog(LOG_WARNING, "[%s] io_uring unavailable, falling back to epoll",
+				__func__);
+		}
 	}
+#endif
 
-	app->rb.tx = varchunk_new(8192, true);
-	if(!app->rb.tx)
+	const int epfd = epoll_create1(EPOLL_CLOEXEC);
+	if(epfd == -1)
 	{
-		goto failure;
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		_quit(); // end all loops
+		return NULL;
 	}
 
-	if(lv2_osc_stream_init(&app->stream, app->url, &driver, app) != 0)
+	if(  (_epoll_add(epfd, quit, EPOLLIN) != 0)
+		|| (_epoll_add(epfd, input->wake, EPOLLIN) != 0)
+		|| (_epoll_add(epfd, input->stream.sock, EPOLLIN | EPOLLET) != 0) )
 	{
 		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
-		goto failure;
+		close(epfd);
+		_quit(); // end all loops
+		return NULL;
 	}
 
-	return 0;
+	int timeout_ms = 0; // run once right away, e.g. to connect
 
-failure:
-	_osc_deinit(app);
-	return -1;
+	while(!atomic_load(&done))
+	{
+		struct epoll_event evs [3 + LV2_OSC_STREAM_CLIENTS];
+
+		const int nevs = epoll_wait(epfd, evs, 3 + LV2_OSC_STREAM_CLIENTS, timeout_ms);
+		if(nevs == -1)
+		{
+			if(errno != EINTR)
+			{
+				syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+			}
+
+			continue;
+		}
+
+		for(int i = 0; i < nevs; i++)
+		{
+			if(evs[i].data.fd == input->wake)
+			{
+				eventfd_t val;
+				eventfd_read(input->wake, &val);
+			}
+		}
+
+		// receive, accept and send pending replies
+		_input_run(input, epfd);
+
+		// retry shortly while the ringbuffer is full, as the socket or the batch
+		// has been left undrained, clients (re)connect periodically, servers
+		// block until woken
+		if(  !_write_req(input, LV2_OSC_STREAM_REQBUF, NULL)
+			|| lv2_osc_stream_pending(&input->stream) )
+		{
+			timeout_ms = 1;
+		}
+		else if(!input->stream.server)
+		{
+			timeout_ms = 1000;
+		}
+		else
+		{
+			timeout_ms = -1;
+		}
+	}
+
+	close(epfd);
+
+	return NULL;
 }
 
-static void
-_thread_priority(int priority)
+static int
+_thread_init(app_t *app)
 {
-		if(priority == 0)
+	for(uint32_t i = 0; i < app->nports; i++)
+	{
+		port_t *port = &app->ports[i];
+
+		// start out with blank frames, resolved frames are published by _frame
+		port->tb.back = 0;
+		atomic_init(&port->tb.latest, 1);
+		port->tb.front = 2;
+		memset(port->tb.buf, 0x0, sizeof(port->tb.buf));
+
+		for(uint32_t j = 0; j < 3; j++)
 		{
-			return;
+			port->tb.buf[j].nslots = port->nslots;
 		}
 
-		const struct sched_param schedp = {
-			.sched_priority = priority
-		};
+		// start out with empty statistics, published by the owning thread
+		port->snap.back = 0;
+		atomic_init(&port->snap.latest, 1);
+		port->snap.front = 2;
+		memset(port->snap.buf, 0x0, sizeof(port->snap.buf));
 
-		const pthread_t self = pthread_self();
+		for(uint32_t j = 0; j < 3; j++)
+		{
+			for(stat_t stat = 0; stat < STAT_MAX; stat++)
+			{
+				hist_clear(&port->snap.buf[j].stat[stat]);
+			}
+		}
+	}
 
-		if(pthread_setschedparam(self, SCHED_FIFO, &schedp) != 0)
+	if(sem_init(&app->adaptive.sem, 0, 0) != 0)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		return -1;
+	}
+
+	if(pthread_create(&app->thread, NULL,
+		app->adaptive.enabled ? _beat_adaptive : _beat, app) != 0)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		sem_destroy(&app->adaptive.sem);
+		return -1;
+	}
+
+	for(uint32_t i = 0; app->workers && (i < app->nports); i++)
+	{
+		port_t *port = &app->ports[i];
+
+		if(pthread_create(&port->thread, NULL, _worker, port) != 0)
 		{
 			syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+
+			_quit();
+			while(i--)
+			{
+				pthread_join(app->ports[i].thread, NULL);
+			}
+
+			sem_post(&app->adaptive.sem);
+			pthread_join(app->thread, NULL);
+			sem_destroy(&app->adaptive.sem);
+			return -1;
 		}
+	}
+
+	_recover_init(app);
+
+	return 0;
 }
 
-static void *
-_beat(void *data)
+static void
+_thread_deinit(app_t *app)
 {
-	app_t *app = data;
-	state_t *state = &app->state;
+	sem_post(&app->adaptive.sem); // wake up output thread
+	pthread_join(app->thread, NULL);
+	sem_destroy(&app->adaptive.sem);
 
-	const uint64_t step_ns = NSECS / app->fps;
+	for(uint32_t i = 0; app->workers && (i < app->nports); i++)
+	{
+		pthread_join(app->ports[i].thread, NULL);
+	}
 
-	_thread_priority(app->priority.out);
+	_recover_deinit(app);
+}
+
+static void
+_sched_deinit(app_t *app)
+{
+	for(sched_t *elmnt = app->list; elmnt; elmnt = app->list)
+	{
+		app->list = elmnt->next;
+		free(elmnt);
+	}
+}
+
+static int
+_event_loop(app_t *app)
+{
+	uint64_t step_ns = app->step_ns;
+
+	const int epfd = epoll_create1(0);
+	if(epfd == -1)
+	{
+		goto failure;
+	}
+
+	const int tfd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK);
+	if(tfd == -1)
+	{
+		goto failure_epoll;
+	}
 
 	struct timespec to;
 	clock_gettime(CLOCK_REALTIME, &to);
 
+	// fixed frame rate uses a periodic timer, adaptive one a one-shot timer
+	const struct itimerspec spec = {
+		.it_interval = {
+			.tv_sec = app->adaptive.enabled ? 0 : step_ns / NSECS,
+			.tv_nsec = app->adaptive.enabled ? 0 : step_ns % NSECS
+		},
+		.it_value = to
+	};
+
+	if(timerfd_settime(tfd, TFD_TIMER_ABSTIME, &spec, NULL) == -1)
+	{
+		goto failure_timer;
+	}
+
+	if(  (_epoll_add(epfd, tfd, EPOLLIN) != 0)
+		|| (_epoll_add(epfd, quit, EPOLLIN) != 0) )
+	{
+		goto failure_timer;
+	}
+
+	for(uint32_t i = 0; i < app->ninputs; i++)
+	{
+		if(_epoll_add(epfd, app->inputs[i].stream.sock, EPOLLIN | EPOLLET) != 0)
+		{
+			goto failure_timer;
+		}
+	}
+
+	if(app->adaptive.enabled)
+	{
+		_adaptive_init(app);
+	}
+
+	_recover_init(app);
+
+	if( (app->recover.wake != -1)
+		&& (_epoll_add(epfd, app->recover.wake, EPOLLIN) != 0) )
+	{
+		_quit(); // end recovery thread
+		_recover_deinit(app);
+		goto failure_timer;
+	}
+
+	_thread_priority(app->priority.out);
+	_thread_affinity(app->affinity.out);
+	_thread_prefault(app);
+
 	while(!atomic_load(&done))
 	{
-		// sleep until next beat timestamp
-		if(clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &to, NULL) == -1)
+		struct epoll_event evs [3 + MAX_INPUTS*(1 + LV2_OSC_STREAM_CLIENTS)];
+
+		const int nevs = epoll_wait(epfd, evs,
+			3 + MAX_INPUTS*(1 + LV2_OSC_STREAM_CLIENTS), -1);
+		if(nevs == -1)
 		{
+			if(errno != EINTR)
+			{
+				syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+			}
+
 			continue;
 		}
 
-		// read OSC messages from ringbuffer
-		const uint8_t *buf;
-		size_t len;
-		while( (buf = varchunk_read_request(app->rb.rx, &len)) )
+		bool ready [MAX_INPUTS] = { false };
+		bool timer = false;
+
+		for(int i = 0; i < nevs; i++)
 		{
-			_handle_osc_packet(app, LV2_OSC_IMMEDIATE, buf, len);
+			if(evs[i].data.fd == quit)
+			{
+				continue;
+			}
+
+			// adapter reconnected in the background
+			if(evs[i].data.fd == app->recover.wake)
+			{
+				eventfd_t val;
+				eventfd_read(app->recover.wake, &val);
+
+				app->adaptive.pending = true;
+				continue;
+			}
+
+			if(evs[i].data.fd != tfd)
+			{
+				for(uint32_t j = 0; j < app->ninputs; j++)
+				{
+					ready[j] |= _input_ready(&app->inputs[j], evs[i].data.fd);
+				}
+
+				continue;
+			}
+
+			uint64_t expired;
+			if(read(tfd, &expired, sizeof(expired)) != sizeof(expired))
+			{
+				continue;
+			}
+
+			if(app->adaptive.enabled)
+			{
+				timer = true;
+				continue;
+			}
+
+			// skip missed beats
+			_ts_add(&to, (expired - 1) * step_ns);
 
-			varchunk_read_advance(app->rb.rx);
+			struct timespec t0;
+			clock_gettime(CLOCK_REALTIME, &t0);
+			hist_add(&app->stat[STAT_WAKEUP], _ts_lapse(&t0, &to));
+
+			if(_frame(app, &to, &t0, true) == -1)
+			{
+				_quit(); // end xmit loop
+			}
+
+			// calculate next beat timestamp
+			_ts_add(&to, step_ns);
+
+			if(_step_update(app))
+			{
+				step_ns = app->step_ns;
+
+				const struct itimerspec respec = {
+					.it_interval = {
+						.tv_sec = step_ns / NSECS,
+						.tv_nsec = step_ns % NSECS
+					},
+					.it_value = to
+				};
+
+				timerfd_settime(tfd, TFD_TIMER_ABSTIME, &respec, NULL);
+			}
 		}
 
-		// read OSC messages from list
-		for(sched_t *elmnt = app->list; elmnt; elmnt = app->list)
+		// dispatch OSC packets of ready inputs directly
+		for(uint32_t i = 0; i < app->ninputs; i++)
 		{
-			double diff = to.tv_sec - elmnt->to.tv_sec;
-			diff += (to.tv_nsec - elmnt->to.tv_nsec) * 1e-9;
-
-			if(diff < 0.0)
+			if(ready[i])
 			{
-				break;
+				_input_run(&app->inputs[i], epfd);
 			}
+		}
+
+		if(app->adaptive.enabled)
+		{
+			struct timespec t0;
+			clock_gettime(CLOCK_REALTIME, &t0);
+
+			_adaptive_deadline(app, app->adaptive.pending, &to);
+
+			if(_ts_diff(&t0, &to) >= 0)
+			{
+				if(timer)
+				{
+					hist_add(&app->stat[STAT_WAKEUP], _ts_lapse(&t0, &to));
+				}
 
-			_handle_osc_packet(app, LV2_OSC_IMMEDIATE, elmnt->buf, elmnt->len);
+				if(_frame(app, &t0, &t0, _adaptive_refresh(app, &t0)) == -1)
+				{
+					_quit(); // end xmit loop
+				}
 
-			app->list = elmnt->next;
-			free(elmnt);
-		}
+				_step_update(app);
+				_adaptive_deadline(app, false, &to);
+			}
 
-		// fill dmx buffer
-		for(uint32_t i = 0; i < 512; i++)
-		{
-			slot_t *slot = &state->slots[i];
+			// arm timer for next keep-alive refresh, scheduled or pending message
+			const struct itimerspec next = {
+				.it_value = to
+			};
 
-			app->dmx.data[i] = slot_get_val(slot);
+			timerfd_settime(tfd, TFD_TIMER_ABSTIME, &next, NULL);
 		}
 
-		// write DMX data
-		if(_ftdi_xmit(app) != 0)
+		// flush pending replies
+		for(uint32_t i = 0; i < app->ninputs; i++)
 		{
-			atomic_store(&done, true); // end xmit loop
-		}
+			input_t *input = &app->inputs[i];
+			size_t len;
 
-		// calculate next beat timestamp
-		to.tv_nsec += step_ns;
-		while(to.tv_nsec >= NSECS)
-		{
-			to.tv_sec += 1;
-			to.tv_nsec -= NSECS;
+			if(varchunk_read_request(input->rb.tx, &len))
+			{
+				_input_run(input, epfd);
+			}
 		}
 	}
 
-	return NULL;
-}
-
-static int
-_thread_init(app_t *app)
-{
-	if(pthread_create(&app->thread, NULL, _beat, app) != 0)
-	{
-		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
-		return -1;
-	}
+	_recover_deinit(app);
+	close(tfd);
+	close(epfd);
 
 	return 0;
-}
 
-static void
-_thread_deinit(app_t *app)
-{
-	pthread_join(app->thread, NULL);
-}
+failure_timer:
+	close(tfd);
 
-static void
-_sched_deinit(app_t *app)
-{
-	for(sched_t *elmnt = app->list; elmnt; elmnt = app->list)
-	{
-		app->list = elmnt->next;
-		free(elmnt);
-	}
+failure_epoll:
+	close(epfd);
+
+failure:
+	syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+	return -1;
 }
 
 static int
@@ -534,36 +3629,72 @@ _loop(app_t *app)
 		return -1;
 	}
 
-	if(_ftdi_init(app) == -1)
+	if(_output_init(app) == -1)
 	{
 		_osc_deinit(app);
 		return -1;
 	}
 
-	if(_thread_init(app) == -1)
+	if(atomic_load(&reconnect))
 	{
-		_ftdi_deinit(app);
-		_osc_deinit(app);
-		return -1;
+		_hotplug_init(app);
 	}
 
+	_mem_prefault(app);
+
 	atomic_store(&done, false);
 
-	_thread_priority(app->priority.inp);
+	eventfd_t val;
+	eventfd_read(quit, &val); // clear pending shutdown
 
-	while(!atomic_load(&done))
+	if(app->single)
+	{
+		if(_event_loop(app) == -1)
+		{
+			_hotplug_deinit(app);
+			_output_deinit(app);
+			_osc_deinit(app);
+			return -1;
+		}
+	}
+	else
 	{
-		const LV2_OSC_Enum status = lv2_osc_stream_pollin(&app->stream, 1000);
+		if(_thread_init(app) == -1)
+		{
+			_hotplug_deinit(app);
+			_output_deinit(app);
+			_osc_deinit(app);
+			return -1;
+		}
 
-		if(status & LV2_OSC_ERR)
+		// serve further inputs on own threads, the first one on this thread
+		uint32_t nthreads = 1;
+
+		for( ; nthreads < app->ninputs; nthreads++)
 		{
-			syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+			input_t *input = &app->inputs[nthreads];
+
+			if(pthread_create(&input->thread, NULL, _input, input) != 0)
+			{
+				syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+				_quit(); // end all loops
+				break;
+			}
+		}
+
+		_input(&app->inputs[0]);
+
+		for(uint32_t i = 1; i < nthreads; i++)
+		{
+			pthread_join(app->inputs[i].thread, NULL);
 		}
+
+		_thread_deinit(app);
 	}
 
-	_thread_deinit(app);
 	_sched_deinit(app);
-	_ftdi_deinit(app);
+	_hotplug_deinit(app);
+	_output_deinit(app);
 	_osc_deinit(app);
 
 	return 0;
@@ -603,14 +3734,59 @@ _usage(char **argv, app_t *app)
 		"   [-A]                     enable auto-reconnect (disabled)\n"
 		"   [-V] VID                 USB vendor ID (0x%04"PRIx16")\n"
 		"   [-P] PID                 USB product ID (0x%04"PRIx16")\n"
-		"   [-D] DESCRIPTION         USB product name (%s)\n"
-		"   [-S] SERIAL              USB serial ID (%s)\n"
-		"   [-F] FPS                 Frame rate (%"PRIu32")\n"
+		"   [-D] DESCRIPTION         USB product name, once per adapter (none)\n"
+		"   [-S] SERIAL              USB serial ID, once per adapter (none)\n"
+		"   [-u] UNIVERSE            DMX universe, once per adapter (0, 1, ...)\n"
+		"   [-F] FPS                 Frame rate or 'max' (%"PRIu32")\n"
+		"   [-b] BREAK               DMX break duration in us (%"PRIu32")\n"
+		"   [-m] MAB                 DMX mark-after-break duration in us (%"PRIu32")\n"
+		"   [-l] LATENCY             USB latency timer in ms (device default)\n"
+		"   [-c] CHUNKSIZE           USB write chunk size in bytes (library default)\n"
+		"   [-t]                     Time a couple of frames upon first opening an adapter\n"
+		"   [-N] SLOTS               DMX slots per frame or 'auto' (%"PRIu32")\n"
 		"   [-U] URI                 OSC URI (%s)\n"
 		"   [-I] PRIORITY            Input (OSC) realtime thread priority (%i)\n"
-		"   [-O] PRIORITY            Output (DMX) realtime thread priority(%i)\n\n"
-		, argv[0], app->vid, app->pid, app->des, app->sid, app->fps, app->url,
-		app->priority.inp, app->priority.out);
+		"   [-O] PRIORITY            Output (DMX) realtime thread priority(%i)\n"
+		"   [-W] MARGIN              Output (DMX) spin wakeup margin in us or 'auto' (disabled)\n"
+		"   [-i] CPU                 Input (OSC) thread CPU affinity (%i)\n"
+		"   [-o] CPU                 Output (DMX) thread CPU affinity (%i)\n"
+		"   [-M]                     lock and prefault memory (disabled)\n"
+		"   [-E]                     single-threaded event loop (disabled)\n"
+		"   [-K] FPS                 change-driven output with keep-alive frame rate (disabled)\n"
+		"   [-a]                     asynchronous double-buffered USB writes (disabled)\n"
+		"   [-w]                     one output (DMX) worker thread per adapter (disabled)\n"
+		"   [-f] FPS                 worker frame rate or 'max', once per adapter (FPS)\n"
+		"   [-z]                     stagger worker phases over the frame period (disabled)\n"
+		"   [-p] FILE                logical to physical channel patch table (none)\n"
+		"   [-T] BACKEND             output to 'ftdi', 'tty:DEVICE[,...]', 'pro[:DEVICE[,...]]', 'null', 'file:PATH' or 'pty' (ftdi)\n"
+		"   [-R] COUNT               OSC input sockets sharing the port, one thread each (1)\n"
+		"   [-Q]                     io_uring receive of OSC UDP datagrams (disabled)\n\n"
+		, argv[0], app->vid, app->pid, app->fps,
+		app->timing.break_us, app->timing.mab_us, app->slots, app->url,
+		app->priority.inp, app->priority.out, app->affinity.inp, app->affinity.out);
+}
+
+static int
+_fps_parse(const char *arg, uint32_t *fps)
+{
+	if(strcmp(arg, "max") == 0)
+	{
+		*fps = 0; // derive from DMX wire timing
+		return 0;
+	}
+
+	char *end = NULL;
+	const long val = strtol(arg, &end, 10);
+
+	if( (end == arg) || (*end != '\0') || (val < 1) || (val > UINT32_MAX) )
+	{
+		fprintf(stderr, "Frame rate out of range `%s'.\n", arg);
+		return -1;
+	}
+
+	*fps = val;
+
+	return 0;
 }
 
 int
@@ -618,16 +3794,44 @@ main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
 {
 	static app_t app;
 	int logp = LOG_INFO;
+	uint32_t ndes = 0;
+	uint32_t nsid = 0;
+	uint32_t nuni = 0;
+	uint32_t nfps = 0;
 
 	app.vid = FTDI_VID;
 	app.pid = FT232_PID;
-	app.des = NULL;
-	app.sid = NULL;
 	app.fps = 30;
+	app.timing.break_us = 176;
+	app.timing.mab_us = 12;
+	app.usb_cfg.latency_ms = 0;
+	app.usb_cfg.chunksize = 0;
+	app.usb_cfg.selftest = false;
+	app.slots = 512;
 	app.url = "osc.udp://:6666";
 	app.priority.inp = 0;
 	app.priority.out = 0;
+	app.spin.enabled = false;
+	app.spin.calibrate = false;
+	app.spin.margin_ns = 0;
+	hist_clear(&app.spin.window);
+	app.affinity.inp = -1;
+	app.affinity.out = -1;
+	app.prefault = false;
+	app.single = false;
+	app.workers = false;
+	app.stagger = false;
+	app.adaptive.enabled = false;
+	app.adaptive.fps = 1;
+	app.async.enabled = false;
+	app.backend = &backends[0];
+	app.sink.path = NULL;
+	app.ninputs = 1;
 
+	for(stat_t stat = 0; stat < STAT_MAX; stat++)
+	{
+		hist_clear(&app.stat[stat]);
+	}
 
 	fprintf(stderr,
 		"%s "OSC2FTDIDMX_VERSION"\n"
@@ -636,7 +3840,7 @@ main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
 		argv[0]);
 
 	int c;
-	while( (c = getopt(argc, argv, "vhdAV:P:D:S:F:U:I:O:") ) != -1)
+	while( (c = getopt(argc, argv, "vhdAV:P:D:S:u:f:wzp:T:R:QF:b:m:l:c:tN:U:I:O:W:i:o:MEK:a") ) != -1)
 	{
 		switch(c)
 		{
@@ -668,15 +3872,108 @@ main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
 			} break;
 			case 'D':
 			{
-				app.des = optarg;
+				if(ndes >= MAX_PORTS)
+				{
+					fprintf(stderr, "Too many adapters, maximum is %i.\n", MAX_PORTS);
+					return -1;
+				}
+
+				app.ports[ndes++].des = optarg;
 			} break;
 			case 'S':
 			{
-				app.sid = optarg;
+				if(nsid >= MAX_PORTS)
+				{
+					fprintf(stderr, "Too many adapters, maximum is %i.\n", MAX_PORTS);
+					return -1;
+				}
+
+				app.ports[nsid++].sid = optarg;
+			} break;
+			case 'u':
+			{
+				if(nuni >= MAX_PORTS)
+				{
+					fprintf(stderr, "Too many adapters, maximum is %i.\n", MAX_PORTS);
+					return -1;
+				}
+
+				const long universe = strtol(optarg, NULL, 10);
+
+				if( (universe < 0) || (universe >= MAX_UNIVERSES) )
+				{
+					fprintf(stderr, "Universe out of range `%s'.\n", optarg);
+					return -1;
+				}
+
+				app.ports[nuni++].universe = universe;
+			} break;
+			case 'f':
+			{
+				if(nfps >= MAX_PORTS)
+				{
+					fprintf(stderr, "Too many adapters, maximum is %i.\n", MAX_PORTS);
+					return -1;
+				}
+
+				if(_fps_parse(optarg, &app.ports[nfps++].fps) != 0)
+				{
+					return -1;
+				}
+			} break;
+			case 'w':
+			{
+				app.workers = true;
+			} break;
+			case 'p':
+			{
+				app.patch.path = optarg;
+			} break;
+			case 'z':
+			{
+				app.stagger = true;
 			} break;
 			case 'F':
 			{
-				app.fps = strtol(optarg, NULL, 10);;
+				if(_fps_parse(optarg, &app.fps) != 0)
+				{
+					return -1;
+				}
+			} break;
+			case 'b':
+			{
+				app.timing.break_us = strtol(optarg, NULL, 10);
+			} break;
+			case 'm':
+			{
+				app.timing.mab_us = strtol(optarg, NULL, 10);
+			} break;
+			case 'l':
+			{
+				const long latency_ms = strtol(optarg, NULL, 10);
+
+				app.usb_cfg.latency_ms = latency_ms < 1
+					? 1
+					: (latency_ms > 255 ? 255 : latency_ms);
+			} break;
+			case 'c':
+			{
+				app.usb_cfg.chunksize = strtol(optarg, NULL, 10);
+			} break;
+			case 't':
+			{
+				app.usb_cfg.selftest = true;
+			} break;
+			case 'N':
+			{
+				app.slots = strcmp(optarg, "auto") == 0
+					? 0 // up to highest active channel
+					: strtol(optarg, NULL, 10);
+
+				if(app.slots > 512)
+				{
+					app.slots = 512;
+				}
 			} break;
 			case 'U':
 			{
@@ -690,12 +3987,113 @@ main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
 			{
 				app.priority.out = strtol(optarg, NULL, 10);
 			} break;
+			case 'W':
+			{
+				app.spin.enabled = true;
+
+				if(strcmp(optarg, "auto") == 0)
+				{
+					app.spin.calibrate = true;
+					app.spin.margin_ns = 200000; // until calibrated
+				}
+				else
+				{
+					char *end = NULL;
+					const long margin_us = strtol(optarg, &end, 10);
+
+					if( (end == optarg) || (*end != '\0') || (margin_us < 0) )
+					{
+						fprintf(stderr, "Spin margin out of range `%s'.\n", optarg);
+						return -1;
+					}
+
+					app.spin.margin_ns = margin_us * 1000;
+				}
+			} break;
+			case 'i':
+			{
+				app.affinity.inp = strtol(optarg, NULL, 10);
+			} break;
+			case 'o':
+			{
+				app.affinity.out = strtol(optarg, NULL, 10);
+			} break;
+			case 'M':
+			{
+				app.prefault = true;
+			} break;
+			case 'E':
+			{
+				app.single = true;
+			} break;
+			case 'K':
+			{
+				app.adaptive.enabled = true;
+				app.adaptive.fps = strtol(optarg, NULL, 10);
+			} break;
+			case 'a':
+			{
+				app.async.enabled = true;
+			} break;
+			case 'Q':
+			{
+				app.uring.enabled = true;
+			} break;
+			case 'T':
+			{
+				// backends may take a path after a colon
+				const char *colon = strchr(optarg, ':');
+				const size_t len = colon ? (size_t)(colon - optarg) : strlen(optarg);
+
+				app.backend = NULL;
+				for(const backend_t *backend = backends; backend->name; backend++)
+				{
+					if( (strlen(backend->name) == len)
+						&& (strncmp(optarg, backend->name, len) == 0) )
+					{
+						app.backend = backend;
+						break;
+					}
+				}
+
+				if(!app.backend)
+				{
+					fprintf(stderr, "Unknown output backend `%s'.\n", optarg);
+					return -1;
+				}
+
+				app.sink.path = colon ? colon + 1 : NULL;
+
+				if(app.backend->path && !app.sink.path)
+				{
+					fprintf(stderr, "Output backend `%s' requires a path.\n", optarg);
+					return -1;
+				}
+			} break;
+			case 'R':
+			{
+				const long ninputs = strtol(optarg, NULL, 10);
+
+				if( (ninputs < 1) || (ninputs > MAX_INPUTS) )
+				{
+					fprintf(stderr, "Input count out of range `%s', maximum is %i.\n",
+						optarg, MAX_INPUTS);
+					return -1;
+				}
+
+				app.ninputs = ninputs;
+			} break;
 
 			case '?':
 			{
 				if(  (optopt == 'V') || (optopt == 'P') || (optopt == 'D')
 					|| (optopt == 'S') || (optopt == 'F') || (optopt == 'U')
-					|| (optopt == 'I') || (optopt == 'O') )
+					|| (optopt == 'I') || (optopt == 'O') || (optopt == 'W')
+					|| (optopt == 'i') || (optopt == 'o') || (optopt == 'K')
+					|| (optopt == 'b') || (optopt == 'm') || (optopt == 'N')
+					|| (optopt == 'l') || (optopt == 'c')
+					|| (optopt == 'u') || (optopt == 'f') || (optopt == 'p')
+					|| (optopt == 'T') || (optopt == 'R') )
 				{
 					fprintf(stderr, "Option `-%c' requires an argument.\n", optopt);
 				}
@@ -715,13 +4113,169 @@ main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
 		}
 	}
 
+	openlog(NULL, LOG_PERROR, LOG_DAEMON);
+	setlogmask(LOG_UPTO(logp));
+
+#if !defined(HAVE_LIBFTDI1)
+	if(app.async.enabled)
+	{
+		syslog(LOG_WARNING, "[%s] asynchronous writes require libftdi1", __func__);
+		app.async.enabled = false;
+	}
+#endif
+
+#if !defined(HAVE_LIBURING)
+	if(app.uring.enabled)
+	{
+		syslog(LOG_WARNING, "[%s] io_uring receive requires liburing", __func__);
+		app.uring.enabled = false;
+	}
+#endif
+
+	// n-th -D, -S, -u and -f configure the n-th adapter
+	app.nports = ndes > nsid ? ndes : nsid;
+	if(nuni > app.nports)
+	{
+		app.nports = nuni;
+	}
+	if(nfps > app.nports)
+	{
+		app.nports = nfps;
+	}
+	if(app.nports == 0)
+	{
+		app.nports = 1;
+	}
+
+	for(uint32_t i = 0; i < app.nports; i++)
+	{
+		port_t *port = &app.ports[i];
+
+		port->app = &app;
+
+		if(i >= nuni)
+		{
+			port->universe = i;
+		}
+
+		if(i >= nfps)
+		{
+			port->fps = app.fps;
+		}
+
+		port->nslots = app.slots
+			? app.slots
+			: DMX_MIN_SLOTS;
+
+		// further adapters with the same universe mirror the first one
+		for(uint32_t j = 0; j < i; j++)
+		{
+			if(app.ports[j].universe == port->universe)
+			{
+				port->mirror = &app.ports[j];
+				break;
+			}
+		}
+
+		for(stat_t stat = 0; stat < STAT_MAX; stat++)
+		{
+			hist_clear(&port->stat[stat]);
+		}
+
+		// make universe visible to patterns right away
+		if(!state_universe(&app.state, port->universe, true))
+		{
+			return -1;
+		}
+	}
+
+	if(app.patch.path && (_patch_load(&app, app.patch.path) != 0) )
+	{
+		return -1;
+	}
+
+	if(app.fps == 0) // back-to-back frames
+	{
+		app.max_rate = true;
+		app.step_ns = dmx_frame_ns(app.timing.break_us, app.timing.mab_us,
+			sizeof(app.ports[0].dmx[0].start_code) + app.ports[0].nslots);
+		app.fps = NSECS / app.step_ns;
+
+		syslog(LOG_INFO, "[%s] maximum frame rate: %.2f fps", __func__,
+			(double)NSECS / app.step_ns);
+	}
+	else
+	{
+		app.step_ns = NSECS / app.fps;
+	}
+
+	if(app.uring.enabled && app.single)
+	{
+		syslog(LOG_WARNING, "[%s] io_uring receive requires threaded input", __func__);
+		app.uring.enabled = false;
+	}
+
+	if(app.workers && (app.single || app.adaptive.enabled) )
+	{
+		syslog(LOG_WARNING, "[%s] output workers require threaded fixed-rate output", __func__);
+		app.workers = false;
+	}
+
+	// per-adapter frame clocks, dispatch keeps up with the fastest one
+	for(uint32_t i = 0; app.workers && (i < app.nports); i++)
+	{
+		port_t *port = &app.ports[i];
+
+		if(port->fps == 0)
+		{
+			port->max_rate = true;
+			port->step_ns = dmx_frame_ns(app.timing.break_us, app.timing.mab_us,
+				sizeof(port->dmx[0].start_code) + port->nslots);
+		}
+		else
+		{
+			port->step_ns = NSECS / port->fps;
+		}
+
+		if(port->step_ns < app.step_ns)
+		{
+			app.step_ns = port->step_ns;
+			app.fps = NSECS / app.step_ns;
+		}
+
+		// spread USB transfers evenly over the frame period
+		port->phase_ns = app.stagger
+			? i * port->step_ns / app.nports
+			: 0;
+	}
+
+	// receivers consider the signal lost after one second without refresh
+	if(app.adaptive.fps < 1)
+	{
+		app.adaptive.fps = 1;
+	}
+	else if(app.adaptive.fps > app.fps)
+	{
+		app.adaptive.fps = app.fps;
+	}
+
+	quit = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(quit == -1)
+	{
+		syslog(LOG_ERR, "[%s] '%s'", __func__, strerror(errno));
+		return -1;
+	}
+
 	signal(SIGINT, _sig);
 	signal(SIGTERM, _sig);
 	signal(SIGQUIT, _sig);
 	signal(SIGKILL, _sig);
+	signal(SIGUSR1, _sig_dump);
 
-	openlog(NULL, LOG_PERROR, LOG_DAEMON);
-	setlogmask(LOG_UPTO(logp));
+	if(app.prefault && (_mem_lock() != 0) )
+	{
+		return -1;
+	}
 
 	int ret = _loop(&app);
 
@@ -733,5 +4287,8 @@ main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
 		ret = _loop(&app);
 	}
 
+	state_deinit(&app.state);
+	close(quit);
+
 	return ret;
 }
@@ -51,6 +51,22 @@
 #	define LV2_OSC_STREAM_REQBUF 1024
 #endif
 
+#if !defined(LV2_OSC_STREAM_CLIENTS)
+#	define LV2_OSC_STREAM_CLIENTS 8 // concurrent connections of TCP server
+#endif
+
+#if !defined(LV2_OSC_STREAM_MMSG)
+#	define LV2_OSC_STREAM_MMSG 32 // datagrams per batch, 0 to disable
+#endif
+
+#if !defined(LV2_OSC_STREAM_MMSG_SIZE)
+#	define LV2_OSC_STREAM_MMSG_SIZE 0x2000 // 8 K, maximal batched datagram
+#endif
+
+#if defined(__linux__) && (LV2_OSC_STREAM_MMSG > 0)
+#	define LV2_OSC_STREAM_HAS_MMSG
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -68,6 +84,7 @@ typedef void
 (*LV2_OSC_Stream_Read_Advance)(void *data);
 
 typedef struct _LV2_OSC_Address LV2_OSC_Address;
+typedef struct _LV2_OSC_Client LV2_OSC_Client;
 typedef struct _LV2_OSC_Driver LV2_OSC_Driver;
 typedef struct _LV2_OSC_Stream LV2_OSC_Stream;
 
@@ -79,6 +96,14 @@ struct _LV2_OSC_Address {
 	};
 };
 
+struct _LV2_OSC_Client {
+	int fd;
+	uint32_t gen; // bumped for each connection accepted into this slot
+	LV2_OSC_Address peer;
+	uint8_t rx_buf [0x4000];
+	size_t rx_off;
+};
+
 struct _LV2_OSC_Driver {
 	LV2_OSC_Stream_Write_Request write_req;
 	LV2_OSC_Stream_Write_Advance write_adv;
@@ -94,8 +119,11 @@ struct _LV2_OSC_Stream {
 	bool slip;
 	bool serial;
 	bool connected;
+	bool reuseport;
 	int sock;
-	int fd;
+	LV2_OSC_Client clients [LV2_OSC_STREAM_CLIENTS];
+	uint32_t source; // origin of packets currently written, 0 unless server
+	uint32_t dest; // origin the packet currently read replies to
 	LV2_OSC_Address self;
 	LV2_OSC_Address peer;
 	const LV2_OSC_Driver *driv;
@@ -104,6 +132,14 @@ struct _LV2_OSC_Stream {
 	uint8_t rx_buf [0x4000];
 	size_t rx_off;
 	char url [PATH_MAX];
+#if defined(LV2_OSC_STREAM_HAS_MMSG)
+	uint8_t *mmsg_buf; // batch of datagrams, allocated for UDP streams only
+	struct mmsghdr mmsg_hdr [LV2_OSC_STREAM_MMSG];
+	struct iovec mmsg_iov [LV2_OSC_STREAM_MMSG];
+	struct sockaddr_in6 mmsg_in [LV2_OSC_STREAM_MMSG];
+	unsigned mmsg_head; // first datagram of batch not yet delivered
+	unsigned mmsg_count; // datagrams of batch
+#endif
 };
 
 typedef enum _LV2_OSC_Enum {
@@ -177,11 +213,32 @@ _close_socket(int *fd)
 	}
 }
 
+static void
+_lv2_osc_stream_close(LV2_OSC_Stream *stream)
+{
+	for(unsigned i = 0; i < LV2_OSC_STREAM_CLIENTS; i++)
+	{
+		_close_socket(&stream->clients[i].fd);
+	}
+
+	_close_socket(&stream->sock);
+
+#if defined(LV2_OSC_STREAM_HAS_MMSG)
+	// datagrams of a batch belong to the closed socket
+	stream->mmsg_head = 0;
+	stream->mmsg_count = 0;
+#endif
+}
+
 static int
 lv2_osc_stream_deinit(LV2_OSC_Stream *stream)
 {
-	_close_socket(&stream->fd);
-	_close_socket(&stream->sock);
+	_lv2_osc_stream_close(stream);
+
+#if defined(LV2_OSC_STREAM_HAS_MMSG)
+	free(stream->mmsg_buf);
+	stream->mmsg_buf = NULL;
+#endif
 
 	return 0;
 }
@@ -190,7 +247,7 @@ static int
 _lv2_osc_stream_reinit(LV2_OSC_Stream *stream)
 {
 	LV2_OSC_Enum ev = LV2_OSC_NONE;
-	lv2_osc_stream_deinit(stream);
+	_lv2_osc_stream_close(stream);
 
 	char *dup = strdup(stream->url);
 	if(!dup)
@@ -377,6 +434,16 @@ _lv2_osc_stream_reinit(LV2_OSC_Stream *stream)
 			goto fail;
 		}
 
+#if defined(SO_REUSEPORT)
+		// let several sockets share the port, kernel distributes by sender
+		if(stream->reuseport && setsockopt(stream->sock, SOL_SOCKET,
+			SO_REUSEPORT, &reuseaddr, sizeof(reuseaddr)) == -1)
+		{
+			ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+			goto fail;
+		}
+#endif
+
 		if(stream->socket_family == AF_INET) // IPv4
 		{
 			if(stream->server)
@@ -485,7 +552,7 @@ _lv2_osc_stream_reinit(LV2_OSC_Stream *stream)
 
 				if(stream->server)
 				{
-					if(listen(stream->sock, 1) != 0)
+					if(listen(stream->sock, LV2_OSC_STREAM_CLIENTS) != 0)
 					{
 						ev = LV2_OSC_STREAM_ERRNO(ev, errno);
 						goto fail;
@@ -618,7 +685,7 @@ _lv2_osc_stream_reinit(LV2_OSC_Stream *stream)
 
 				if(stream->server)
 				{
-					if(listen(stream->sock, 1) != 0)
+					if(listen(stream->sock, LV2_OSC_STREAM_CLIENTS) != 0)
 					{
 						ev = LV2_OSC_STREAM_ERRNO(ev, errno);
 						goto fail;
@@ -662,20 +729,47 @@ fail:
 }
 
 static int
-lv2_osc_stream_init(LV2_OSC_Stream *stream, const char *url,
-	const LV2_OSC_Driver *driv, void *data)
+_lv2_osc_stream_init(LV2_OSC_Stream *stream, const char *url,
+	const LV2_OSC_Driver *driv, void *data, bool reuseport)
 {
 	memset(stream, 0x0, sizeof(LV2_OSC_Stream));
 
 	strncpy(stream->url, url, sizeof(stream->url) - 1);
 	stream->driv = driv;
 	stream->data = data;
+	stream->reuseport = reuseport;
 	stream->sock = -1;
-	stream->fd = -1;
+
+	for(unsigned i = 0; i < LV2_OSC_STREAM_CLIENTS; i++)
+	{
+		stream->clients[i].fd = -1;
+	}
+
+#if defined(LV2_OSC_STREAM_HAS_MMSG)
+	// batch buffer for UDP only, without it datagrams are received one by one
+	if(strncmp(url, udp_prefix, strlen(udp_prefix)) == 0)
+	{
+		stream->mmsg_buf = malloc(LV2_OSC_STREAM_MMSG * LV2_OSC_STREAM_MMSG_SIZE);
+	}
+#endif
 
 	return _lv2_osc_stream_reinit(stream);
 }
 
+static int
+lv2_osc_stream_init(LV2_OSC_Stream *stream, const char *url,
+	const LV2_OSC_Driver *driv, void *data)
+{
+	return _lv2_osc_stream_init(stream, url, driv, data, false);
+}
+
+static int
+lv2_osc_stream_init_reuseport(LV2_OSC_Stream *stream, const char *url,
+	const LV2_OSC_Driver *driv, void *data)
+{
+	return _lv2_osc_stream_init(stream, url, driv, data, true);
+}
+
 #define SLIP_END					0300	// 0xC0, 192, indicates end of packet
 #define SLIP_ESC					0333	// 0xDB, 219, indicates byte stuffing
 #define SLIP_END_REPLACE	0334	// 0xDC, 220, ESC ESC_END means END data byte
@@ -731,12 +825,12 @@ lv2_osc_slip_encode_inline(uint8_t *dst, size_t len)
 	return size;
 }
 
-// SLIP decoding
-static size_t 
-lv2_osc_slip_decode_inline(uint8_t *dst, size_t len, size_t *size)
+// SLIP decoding, dst may equal src
+static size_t
+lv2_osc_slip_decode(uint8_t *dst, const uint8_t *from, size_t len, size_t *size)
 {
-	const uint8_t *src = dst;
-	const uint8_t *end = dst + len;
+	const uint8_t *src = from;
+	const uint8_t *end = from + len;
 	uint8_t *ptr = dst;
 
 	bool whole = false;
@@ -766,7 +860,7 @@ lv2_osc_slip_decode_inline(uint8_t *dst, size_t len, size_t *size)
 			src++;
 
 			*size = whole ? ptr - dst : 0;
-			return src - dst;
+			return src - from;
 		}
 		else
 		{
@@ -778,8 +872,15 @@ lv2_osc_slip_decode_inline(uint8_t *dst, size_t len, size_t *size)
 	return 0;
 }
 
+// SLIP decoding in place
+static size_t
+lv2_osc_slip_decode_inline(uint8_t *dst, size_t len, size_t *size)
+{
+	return lv2_osc_slip_decode(dst, dst, len, size);
+}
+
 static LV2_OSC_Enum
-_lv2_osc_stream_run_udp(LV2_OSC_Stream *stream)
+_lv2_osc_stream_send_udp(LV2_OSC_Stream *stream)
 {
 	LV2_OSC_Enum ev = LV2_OSC_NONE;
 
@@ -816,7 +917,103 @@ _lv2_osc_stream_run_udp(LV2_OSC_Stream *stream)
 		}
 	}
 
-	// recv everything
+	return ev;
+}
+
+static LV2_OSC_Enum
+_lv2_osc_stream_run_udp(LV2_OSC_Stream *stream)
+{
+	LV2_OSC_Enum ev = _lv2_osc_stream_send_udp(stream);
+
+#if defined(LV2_OSC_STREAM_HAS_MMSG)
+	// recv everything, in batches of datagrams per syscall
+	if(stream->mmsg_buf)
+	{
+		bool drained = false;
+
+		while(true)
+		{
+			// deliver datagrams of current batch, keep the rest while ring is full
+			for( ; stream->mmsg_head < stream->mmsg_count; stream->mmsg_head++)
+			{
+				const unsigned i = stream->mmsg_head;
+				const struct mmsghdr *hdr = &stream->mmsg_hdr[i];
+				const size_t recvd = hdr->msg_len;
+				uint8_t *buf;
+
+				if(hdr->msg_hdr.msg_flags & MSG_TRUNC)
+				{
+					ev = LV2_OSC_STREAM_ERRNO(ev, EMSGSIZE);
+				}
+				else if(recvd == 0)
+				{
+					// empty datagram
+				}
+				else if( (buf = stream->driv->write_req(stream->data, recvd, NULL)) )
+				{
+					memcpy(buf, &stream->mmsg_buf[i * LV2_OSC_STREAM_MMSG_SIZE], recvd);
+
+					stream->driv->write_adv(stream->data, recvd);
+					ev |= LV2_OSC_RECV;
+
+					// reply to last sender
+					stream->peer.len = hdr->msg_hdr.msg_namelen;
+					memcpy(&stream->peer.in6, &stream->mmsg_in[i], stream->peer.len);
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			if( (stream->mmsg_head < stream->mmsg_count) || drained)
+			{
+				break;
+			}
+
+			// leave datagrams in socket queue while ring is full
+			size_t max_len;
+			if(!stream->driv->write_req(stream->data, LV2_OSC_STREAM_REQBUF, &max_len))
+			{
+				break;
+			}
+
+			for(unsigned i = 0; i < LV2_OSC_STREAM_MMSG; i++)
+			{
+				struct mmsghdr *hdr = &stream->mmsg_hdr[i];
+
+				stream->mmsg_iov[i].iov_base = &stream->mmsg_buf[i * LV2_OSC_STREAM_MMSG_SIZE];
+				stream->mmsg_iov[i].iov_len = LV2_OSC_STREAM_MMSG_SIZE;
+
+				memset(hdr, 0x0, sizeof(*hdr));
+				hdr->msg_hdr.msg_name = &stream->mmsg_in[i];
+				hdr->msg_hdr.msg_namelen = sizeof(stream->mmsg_in[i]);
+				hdr->msg_hdr.msg_iov = &stream->mmsg_iov[i];
+				hdr->msg_hdr.msg_iovlen = 1;
+			}
+
+			const int n = recvmmsg(stream->sock, stream->mmsg_hdr, LV2_OSC_STREAM_MMSG,
+				MSG_DONTWAIT, NULL);
+
+			if(n == -1)
+			{
+				if( (errno != EAGAIN) && (errno != EWOULDBLOCK) )
+				{
+					ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+				}
+
+				// empty queue
+				break;
+			}
+
+			stream->mmsg_head = 0;
+			stream->mmsg_count = n;
+			drained = (n < LV2_OSC_STREAM_MMSG);
+		}
+	}
+	else
+#endif
+	// recv everything, one datagram per syscall
 	{
 		uint8_t *buf;
 		size_t max_len;
@@ -859,285 +1056,418 @@ _lv2_osc_stream_run_udp(LV2_OSC_Stream *stream)
 	return ev;
 }
 
+// identifies a client connection, a reused slot yields a different source
+static inline uint32_t
+_lv2_osc_stream_source(unsigned slot, uint32_t gen)
+{
+	return (gen << 8) | slot;
+}
+
 static LV2_OSC_Enum
-_lv2_osc_stream_run_tcp(LV2_OSC_Stream *stream)
+_lv2_osc_stream_accept_tcp(LV2_OSC_Stream *stream)
 {
 	LV2_OSC_Enum ev = LV2_OSC_NONE;
 
-	// handle connections
-	if(!stream->connected) // no peer
+	// accept all pending connections, for edge-triggered readiness
+	while(true)
 	{
-		if(stream->server)
+		LV2_OSC_Address peer;
+		peer.len = sizeof(peer.in6);
+
+		const int fd = accept(stream->sock, (struct sockaddr *)&peer.in6, &peer.len);
+
+		if(fd < 0)
 		{
-			stream->peer.len = sizeof(stream->peer.in6);
-			stream->fd = accept(stream->sock, (struct sockaddr *)&stream->peer.in6,
-				&stream->peer.len);
+			// no pending connection
+			break;
+		}
 
-			if(stream->fd >= 0)
+		LV2_OSC_Client *client = NULL;
+
+		for(unsigned i = 0; i < LV2_OSC_STREAM_CLIENTS; i++)
+		{
+			if(stream->clients[i].fd < 0)
 			{
-				const int flag = 1;
-				const int sendbuff = LV2_OSC_STREAM_SNDBUF;
-				const int recvbuff = LV2_OSC_STREAM_RCVBUF;
+				client = &stream->clients[i];
+				break;
+			}
+		}
 
-				if(fcntl(stream->fd, F_SETFL, O_NONBLOCK) == -1)
-				{
-					ev = LV2_OSC_STREAM_ERRNO(ev, errno);
-				}
+		if(!client) // refuse clients beyond maximum
+		{
+			close(fd);
+			ev = LV2_OSC_STREAM_ERRNO(ev, EUSERS);
+			continue;
+		}
 
-				if(setsockopt(stream->fd, stream->protocol,
-					TCP_NODELAY, &flag, sizeof(flag)) != 0)
-				{
-					ev = LV2_OSC_STREAM_ERRNO(ev, errno);
-				}
+		const int flag = 1;
+		const int sendbuff = LV2_OSC_STREAM_SNDBUF;
+		const int recvbuff = LV2_OSC_STREAM_RCVBUF;
 
-				if(setsockopt(stream->sock, SOL_SOCKET,
-					SO_KEEPALIVE, &flag, sizeof(flag)) != 0)
-				{
-					ev = LV2_OSC_STREAM_ERRNO(ev, errno);
-				}
+		if(fcntl(fd, F_SETFL, O_NONBLOCK) == -1)
+		{
+			ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+		}
 
-				if(setsockopt(stream->fd, SOL_SOCKET,
-					SO_SNDBUF, &sendbuff, sizeof(sendbuff)) == -1)
-				{
-					ev = LV2_OSC_STREAM_ERRNO(ev, errno);
-				}
+		if(setsockopt(fd, stream->protocol,
+			TCP_NODELAY, &flag, sizeof(flag)) != 0)
+		{
+			ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+		}
 
-				if(setsockopt(stream->fd, SOL_SOCKET,
-					SO_RCVBUF, &recvbuff, sizeof(recvbuff)) == -1)
-				{
-					ev = LV2_OSC_STREAM_ERRNO(ev, errno);
-				}
+		if(setsockopt(fd, SOL_SOCKET,
+			SO_KEEPALIVE, &flag, sizeof(flag)) != 0)
+		{
+			ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+		}
+
+		if(setsockopt(fd, SOL_SOCKET,
+			SO_SNDBUF, &sendbuff, sizeof(sendbuff)) == -1)
+		{
+			ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+		}
+
+		if(setsockopt(fd, SOL_SOCKET,
+			SO_RCVBUF, &recvbuff, sizeof(recvbuff)) == -1)
+		{
+			ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+		}
+
+		client->fd = fd; // orderly accept
+		client->gen++;
+		client->peer = peer;
+		client->rx_off = 0;
+	}
+
+	return ev;
+}
+
+// send to fd, or to the client given by stream->dest with fd NULL
+static LV2_OSC_Enum
+_lv2_osc_stream_send_tcp(LV2_OSC_Stream *stream, int *fd)
+{
+	LV2_OSC_Enum ev = LV2_OSC_NONE;
+	const uint8_t *buf;
+	size_t tosend;
+
+	while( (buf = stream->driv->read_req(stream->data, &tosend)) )
+	{
+		int *dst = fd;
 
-				stream->connected = true; // orderly accept
+		if(!dst)
+		{
+			const unsigned slot = stream->dest & 0xff;
+			LV2_OSC_Client *client = &stream->clients[slot];
+
+			// a slot reused by another connection must not get its replies
+			dst = (slot < LV2_OSC_STREAM_CLIENTS)
+				&& (stream->dest == _lv2_osc_stream_source(slot, client->gen))
+				? &client->fd
+				: NULL;
+		}
+
+		if(!dst || (*dst < 0) ) // recipient has gone, drop
+		{
+			stream->driv->read_adv(stream->data);
+			continue;
+		}
+
+		if(stream->slip) // SLIP framed
+		{
+			if(tosend <= sizeof(stream->tx_buf)) // check if there is enough memory
+			{
+				memcpy(stream->tx_buf, buf, tosend);
+				tosend = lv2_osc_slip_encode_inline(stream->tx_buf, tosend);
 			}
 			else
 			{
-				//ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+				tosend = 0;
 			}
 		}
-		else
+		else // uint32_t prefix frames
 		{
-			if(stream->sock < 0)
-			{
-				ev = _lv2_osc_stream_reinit(stream);
-			}
+			const size_t nsize = tosend + sizeof(uint32_t);
 
-			if(connect(stream->sock, (struct sockaddr *)&stream->peer.in6,
-				stream->peer.len) == 0)
+			if(nsize <= sizeof(stream->tx_buf)) // check if there is enough memory
 			{
-				stream->connected = true; // orderly (re)connect
+				const uint32_t prefix = htonl(tosend);
+
+				memcpy(stream->tx_buf, &prefix, sizeof(uint32_t));
+				memcpy(stream->tx_buf + sizeof(uint32_t), buf, tosend);
+				tosend = nsize;
 			}
 			else
 			{
-				//if(errno == EISCONN)
-				//{
-				//	_close_socket(&stream->sock);
-				//}
+				tosend = 0;
+			}
+		}
 
-				//ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+		const ssize_t sent = tosend
+			? send(*dst, stream->tx_buf, tosend, MSG_NOSIGNAL)
+			: 0;
+
+		if(sent == -1)
+		{
+			if( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+			{
+				// empty queue
+				break;
 			}
+
+			_close_socket(dst);
+			ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+			break;
+		}
+		else if(sent != (ssize_t)tosend)
+		{
+			ev = LV2_OSC_STREAM_ERRNO(ev, EIO);
+			break;
 		}
+
+		stream->driv->read_adv(stream->data);
+		ev |= LV2_OSC_SEND;
 	}
 
-	// send everything
-	if(stream->connected)
+	return ev;
+}
+
+// reassemble SLIP or uint32_t prefix frames of a connection
+static LV2_OSC_Enum
+_lv2_osc_stream_recv_tcp(LV2_OSC_Stream *stream, int *fd,
+	uint8_t *rx_buf, size_t rx_size, size_t *rx_off)
+{
+	LV2_OSC_Enum ev = LV2_OSC_NONE;
+
+	// drain until empty queue, for edge-triggered readiness
+	while(true)
 	{
-		int *fd = stream->server
-			? &stream->fd
-			: &stream->sock;
+		bool empty = false;
+		bool full = false;
 
-		if(*fd >= 0)
+		const ssize_t recvd = recv(*fd, rx_buf + *rx_off, rx_size - *rx_off, 0);
+
+		if( (recvd == -1) && ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) )
 		{
-			const uint8_t *buf;
-			size_t tosend;
+			if(*rx_off == 0)
+			{
+				// empty queue
+				break;
+			}
 
-			while( (buf = stream->driv->read_req(stream->data, &tosend)) )
+			// empty queue, but retry remainder stalled by full ringbuffer
+			empty = true;
+		}
+		else if(recvd == -1)
+		{
+			_close_socket(fd);
+			ev = LV2_OSC_STREAM_ERRNO(ev, errno);
+			break;
+		}
+		else if(recvd == 0)
+		{
+			_close_socket(fd); // orderly shutdown
+			break;
+		}
+		else
+		{
+			*rx_off += recvd;
+		}
+
+		// dispatch whole frames
+		size_t parsed = 0;
+
+		while(parsed < *rx_off)
+		{
+			const uint8_t *ptr = rx_buf + parsed;
+			const size_t avail = *rx_off - parsed;
+			uint8_t *buf;
+
+			if(stream->slip) // SLIP framed
 			{
-				if(stream->slip) // SLIP framed
+				const uint8_t *eof = (avail > 1)
+					? memchr(ptr + 1, SLIP_END, avail - 1)
+					: NULL;
+
+				if(!eof) // incomplete frame
 				{
-					if(tosend <= sizeof(stream->tx_buf)) // check if there is enough memory
-					{
-						memcpy(stream->tx_buf, buf, tosend);
-						tosend = lv2_osc_slip_encode_inline(stream->tx_buf, tosend);
-					}
-					else
-					{
-						tosend = 0;
-					}
+					break;
 				}
-				else // uint32_t prefix frames
+
+				// decoded frame is never larger than encoded one
+				const size_t len = eof - ptr + 1;
+
+				if( !(buf = stream->driv->write_req(stream->data, len, NULL)) )
 				{
-					const size_t nsize = tosend + sizeof(uint32_t);
+					full = true;
+					ev = LV2_OSC_STREAM_ERRNO(ev, ENOMEM);
+					break;
+				}
 
-					if(nsize <= sizeof(stream->tx_buf)) // check if there is enough memory
-					{
-						const uint32_t prefix = htonl(tosend);
+				size_t size;
+				const size_t used = lv2_osc_slip_decode(buf, ptr, len, &size);
 
-						memcpy(stream->tx_buf, &prefix, sizeof(uint32_t));
-						memcpy(stream->tx_buf + sizeof(uint32_t), buf, tosend);
-						tosend = nsize;
-					}
-					else
-					{
-						tosend = 0;
-					}
+				if(size) // dispatch
+				{
+					stream->driv->write_adv(stream->data, size);
+					ev |= LV2_OSC_RECV;
 				}
 
-				const ssize_t sent = tosend
-					? send(*fd, stream->tx_buf, tosend, 0)
-					: 0;
+				parsed += used
+					? used
+					: len; // skip malformed frame
+			}
+			else // uint32_t prefix frames
+			{
+				uint32_t prefix;
 
-				if(sent == -1)
+				if(avail < sizeof(uint32_t)) // incomplete prefix
 				{
-					if( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
-					{
-						// empty queue
-						break;
-					}
+					break;
+				}
+
+				memcpy(&prefix, ptr, sizeof(uint32_t));
+				prefix = ntohl(prefix);
 
+				if(prefix > rx_size - sizeof(uint32_t)) // cannot ever be reassembled
+				{
 					_close_socket(fd);
-					stream->connected = false;
-					ev = LV2_OSC_STREAM_ERRNO(ev, errno);
-					break;
+					*rx_off = 0;
+					ev = LV2_OSC_STREAM_ERRNO(ev, EMSGSIZE);
+					return ev;
 				}
-				else if(sent != (ssize_t)tosend)
+
+				if(avail < sizeof(uint32_t) + prefix) // incomplete frame
 				{
-					ev = LV2_OSC_STREAM_ERRNO(ev, EIO);
 					break;
 				}
 
-				stream->driv->read_adv(stream->data);
-				ev |= LV2_OSC_SEND;
+				if(prefix) // dispatch
+				{
+					if( !(buf = stream->driv->write_req(stream->data, prefix, NULL)) )
+					{
+						full = true;
+						ev = LV2_OSC_STREAM_ERRNO(ev, ENOMEM);
+						break;
+					}
+
+					memcpy(buf, ptr + sizeof(uint32_t), prefix);
+
+					stream->driv->write_adv(stream->data, prefix);
+					ev |= LV2_OSC_RECV;
+				}
+
+				parsed += sizeof(uint32_t) + prefix;
 			}
 		}
-	}
 
-	// recv everything
-	if(stream->connected)
-	{
-		int *fd = stream->server
-			? &stream->fd
-			: &stream->sock;
+		// keep remainder for next call
+		*rx_off -= parsed;
+		memmove(rx_buf, rx_buf + parsed, *rx_off);
 
-		if(*fd >= 0)
+		if(*rx_off == rx_size) // SLIP frame larger than reassembly buffer
 		{
-			if(stream->slip) // SLIP framed
-			{
-				while(true)
-				{
-					ssize_t recvd = recv(*fd, stream->rx_buf + stream->rx_off,
-						sizeof(stream->rx_buf) - stream->rx_off, 0);
+			*rx_off = 0;
+			ev = LV2_OSC_STREAM_ERRNO(ev, EMSGSIZE);
+		}
 
-					if(recvd == -1)
-					{
-						if( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
-						{
-							// empty queue
-							break;
-						}
+		if(empty || full)
+		{
+			break;
+		}
+	}
 
-						_close_socket(fd);
-						stream->connected = false;
-						ev = LV2_OSC_STREAM_ERRNO(ev, errno);
-						break;
-					}
-					else if(recvd == 0)
-					{
-						_close_socket(fd);
-						stream->connected = false; // orderly shutdown
-						break;
-					}
+	return ev;
+}
 
-					uint8_t *ptr = stream->rx_buf;
-					recvd += stream->rx_off;
+static LV2_OSC_Enum
+_lv2_osc_stream_run_tcp(LV2_OSC_Stream *stream)
+{
+	LV2_OSC_Enum ev = LV2_OSC_NONE;
 
-					while(recvd > 0)
-					{
-						size_t size;
-						size_t parsed = lv2_osc_slip_decode_inline(ptr, recvd, &size);
+	if(stream->server)
+	{
+		// handle connections
+		ev |= _lv2_osc_stream_accept_tcp(stream);
 
-						if(size) // dispatch
-						{
-							uint8_t *buf;
+		// send everything, each to the client it replies to
+		ev |= _lv2_osc_stream_send_tcp(stream, NULL);
 
-							if( (buf = stream->driv->write_req(stream->data, size, NULL)) )
-							{
-								memcpy(buf, ptr, size);
+		// recv everything from all clients
+		stream->connected = false;
 
-								stream->driv->write_adv(stream->data, size);
-								ev |= LV2_OSC_RECV;
-							}
-							else
-							{
-								parsed = 0;
-								ev = LV2_OSC_STREAM_ERRNO(ev, ENOMEM);
-							}
-						}
+		for(unsigned i = 0; i < LV2_OSC_STREAM_CLIENTS; i++)
+		{
+			LV2_OSC_Client *client = &stream->clients[i];
 
-						if(parsed)
-						{
-							ptr += parsed;
-							recvd -= parsed;
-						}
-						else
-						{
-							break;
-						}
-					}
+			if(client->fd < 0)
+			{
+				continue;
+			}
 
-					if(recvd > 0) // is there remaining chunk for next call?
-					{
-						memmove(stream->rx_buf, ptr, recvd);
-						stream->rx_off = recvd;
-					}
-					else
-					{
-						stream->rx_off = 0;
-					}
+			// tag packets with their client for the driver
+			stream->source = _lv2_osc_stream_source(i, client->gen);
 
-					break;
-				}
+			const LV2_OSC_Enum rev = _lv2_osc_stream_recv_tcp(stream, &client->fd,
+				client->rx_buf, sizeof(client->rx_buf), &client->rx_off);
+
+			stream->source = 0;
+
+			if(rev & LV2_OSC_RECV)
+			{
+				stream->peer = client->peer;
 			}
-			else // uint32_t prefix frames
+
+			if(client->fd >= 0)
 			{
-				uint8_t *buf;
-				
-				while( (buf = stream->driv->write_req(stream->data,
-					LV2_OSC_STREAM_REQBUF, NULL)) )
-				{
-					uint32_t prefix;
+				stream->connected = true;
+			}
 
-					ssize_t recvd = recv(*fd, &prefix, sizeof(uint32_t), 0);
-					if(recvd == sizeof(uint32_t))
-					{
-						prefix = ntohl(prefix); //FIXME check prefix <= max_len
-						recvd = recv(*fd, buf, prefix, 0);
-					}
-					else if(recvd == -1)
-					{
-						if( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
-						{
-							// empty queue
-							break;
-						}
+			ev |= rev;
+		}
+	}
+	else
+	{
+		// handle connection
+		if(!stream->connected) // no peer
+		{
+			if(stream->sock < 0)
+			{
+				ev = _lv2_osc_stream_reinit(stream);
+			}
 
-						_close_socket(fd);
-						stream->connected = false;
-						ev = LV2_OSC_STREAM_ERRNO(ev, errno);
-						break;
-					}
-					else if(recvd == 0)
-					{
-						_close_socket(fd);
-						stream->connected = false; // orderly shutdown
-						break;
-					}
+			if(connect(stream->sock, (struct sockaddr *)&stream->peer.in6,
+				stream->peer.len) == 0)
+			{
+				stream->connected = true; // orderly (re)connect
+			}
+			else
+			{
+				//if(errno == EISCONN)
+				//{
+				//	_close_socket(&stream->sock);
+				//}
 
-					stream->driv->write_adv(stream->data, recvd);
-					ev |= LV2_OSC_RECV;
-				}
+				//ev = LV2_OSC_STREAM_ERRNO(ev, errno);
 			}
 		}
+
+		// send everything
+		if(stream->connected)
+		{
+			ev |= _lv2_osc_stream_send_tcp(stream, &stream->sock);
+		}
+
+		// recv everything
+		if(stream->connected && (stream->sock >= 0) )
+		{
+			ev |= _lv2_osc_stream_recv_tcp(stream, &stream->sock,
+				stream->rx_buf, sizeof(stream->rx_buf), &stream->rx_off);
+		}
+
+		if(stream->sock < 0)
+		{
+			stream->connected = false;
+		}
 	}
 
 	if(stream->connected)
@@ -1231,17 +1561,24 @@ _lv2_osc_stream_run_ser(LV2_OSC_Stream *stream)
 			{
 				while(true)
 				{
+					bool empty = false;
 					ssize_t recvd = read(fd, stream->rx_buf + stream->rx_off,
 						sizeof(stream->rx_buf) - stream->rx_off);
 
-					if(recvd == -1)
+					if( (recvd == -1) && ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) )
 					{
-						if( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+						if(stream->rx_off == 0)
 						{
 							// empty queue
 							break;
 						}
 
+						// empty queue, but reparse remainder stalled by full ringbuffer
+						empty = true;
+						recvd = 0;
+					}
+					else if(recvd == -1)
+					{
 						stream->connected = false;
 						ev = LV2_OSC_STREAM_ERRNO(ev, errno);
 						break;
@@ -1253,6 +1590,7 @@ _lv2_osc_stream_run_ser(LV2_OSC_Stream *stream)
 					}
 
 					uint8_t *ptr = stream->rx_buf;
+					bool full = false;
 					recvd += stream->rx_off;
 
 					while(recvd > 0)
@@ -1274,6 +1612,7 @@ _lv2_osc_stream_run_ser(LV2_OSC_Stream *stream)
 							else
 							{
 								parsed = 0;
+								full = true;
 								ev = LV2_OSC_STREAM_ERRNO(ev, ENOMEM);
 							}
 						}
@@ -1299,7 +1638,11 @@ _lv2_osc_stream_run_ser(LV2_OSC_Stream *stream)
 						stream->rx_off = 0;
 					}
 
-					break;
+					// drain until empty queue, for edge-triggered readiness
+					if(empty || full || (stream->rx_off == sizeof(stream->rx_buf)) )
+					{
+						break;
+					}
 				}
 			}
 			else // uint32_t prefix frames
@@ -1374,32 +1717,57 @@ lv2_osc_stream_run(LV2_OSC_Stream *stream)
 	return ev;
 }
 
-static LV2_OSC_Enum
+// send pending packets only, for UDP streams received from elsewhere
+static inline LV2_OSC_Enum
+lv2_osc_stream_send(LV2_OSC_Stream *stream)
+{
+	if(stream->socket_type != SOCK_DGRAM)
+	{
+		return LV2_OSC_STREAM_ERRNO(LV2_OSC_NONE, ENOTSUP);
+	}
+
+	return _lv2_osc_stream_send_udp(stream);
+}
+
+// datagrams received but not yet delivered as the ringbuffer was full
+static inline bool
+lv2_osc_stream_pending(LV2_OSC_Stream *stream)
+{
+#if defined(LV2_OSC_STREAM_HAS_MMSG)
+	return stream->mmsg_head < stream->mmsg_count;
+#else
+	(void)stream;
+	return false;
+#endif
+}
+
+static inline LV2_OSC_Enum
 lv2_osc_stream_pollin(LV2_OSC_Stream *stream, int timeout_ms)
 {
-	struct pollfd fds [2] = {
+	struct pollfd fds [1 + LV2_OSC_STREAM_CLIENTS] = {
 		[0] = {
 			.fd = stream->sock,
 			.events = POLLIN,
 			.revents = 0
-		},
-		[1] = {
-			.fd = stream->fd,
-			.events = POLLIN,
-			.revents = 0
 		}
 	};
 
-	const int res = poll(fds, 2, timeout_ms);
+	for(unsigned i = 0; i < LV2_OSC_STREAM_CLIENTS; i++)
+	{
+		fds[1 + i].fd = stream->clients[i].fd; // negative ones are ignored
+		fds[1 + i].events = POLLIN;
+		fds[1 + i].revents = 0;
+	}
+
+	const int res = poll(fds, 1 + LV2_OSC_STREAM_CLIENTS, timeout_ms);
 	if(res < 0)
 	{
 		return LV2_OSC_STREAM_ERRNO(LV2_OSC_NONE, errno);
 	}
 
 #if 0
-	fprintf(stderr, "++ %i: %i %i %i %i\n", res,
-		fds[0].fd, (int)fds[0].revents,
-		fds[1].fd, (int)fds[1].revents);
+	fprintf(stderr, "++ %i: %i %i\n", res,
+		fds[0].fd, (int)fds[0].revents);
 #endif
 
 	return lv2_osc_stream_run(stream);
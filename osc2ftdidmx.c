@@ -15,6 +15,14 @@
  * http://www.perlfoundation.org/artistic_license_2_0.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <asm/termbits.h> // struct termios2, clashes with <termios.h>
+
 #include <osc2ftdidmx.h>
 
 static const LV2_OSC_Tree tree_priority [32+1];
@@ -59,14 +67,229 @@ slot_get_val(slot_t *slot)
 	return 0x0;
 }
 
-static void
-_priority (LV2_OSC_Reader *reader __attribute__((unused)),
-	LV2_OSC_Arg *arg __attribute__((unused)), const LV2_OSC_Tree *tree, void *data)
+universe_t *
+state_universe(state_t *state, uint16_t universe, bool create)
 {
-	state_t *state = data;
+	if(universe >= MAX_UNIVERSES)
+	{
+		return NULL;
+	}
+
+	universe_t *univ = state->universes[universe];
+
+	// allocate lazily upon first use
+	if(!univ && create)
+	{
+		univ = calloc(1, sizeof(universe_t));
+		if(!univ)
+		{
+			syslog(LOG_ERR, "[%s] calloc failed", __func__);
+			return NULL;
+		}
+
+		state->universes[universe] = univ;
+		state->used[universe / 64] |= UINT64_C(1) << (universe % 64);
+	}
+
+	return univ;
+}
+
+void
+state_deinit(state_t *state)
+{
+	for(uint32_t i = 0; i < MAX_UNIVERSES; i++)
+	{
+		free(state->universes[i]);
+		state->universes[i] = NULL;
+	}
+
+	memset(state->used, 0x0, sizeof(state->used));
+}
+
+uint32_t
+state_resolve(state_t *state, uint16_t universe, uint8_t *data)
+{
+	universe_t *univ = state_universe(state, universe, false);
+	uint32_t nslots = 0;
+
+	if(!univ)
+	{
+		memset(data, 0x0, 512);
+		return 0;
+	}
 
-	const uint8_t prio = tree - tree_priority;
+	for(uint32_t i = 0; i < 512; i++)
+	{
+		slot_t *slot = &univ->slots[i];
+
+		data[i] = slot_get_val(slot);
+
+		if(slot_has_val(slot))
+		{
+			nslots = i + 1;
+		}
+	}
+
+	return nslots;
+}
+
+void
+gather_clear(gather_t *gather, uint32_t zero)
+{
+	gather->nslots = 0;
+
+	for(uint32_t i = 0; i < 512; i++)
+	{
+		gather->idx[i] = zero;
+	}
+}
+
+void
+gather_set(gather_t *gather, uint32_t slot, uint32_t idx)
+{
+	gather->idx[slot] = idx;
+
+	if(slot >= gather->nslots)
+	{
+		gather->nslots = slot + 1;
+	}
+}
+
+void
+gather_run(const gather_t *gather, const uint8_t *src, uint8_t *dst)
+{
+	// one branch-free pass, unpatched slots point to a zero byte
+	for(uint32_t i = 0; i < 512; i++)
+	{
+		dst[i] = src[gather->idx[i]];
+	}
+}
 
+int
+patch_parse(char *line, patch_t *patch)
+{
+	patch->num = 1;
+
+	line[strcspn(line, "#")] = '\0'; // strip comments
+
+	const int n = sscanf(line, "%u %u %u %u %u", &patch->lu, &patch->lc,
+		&patch->pu, &patch->ps, &patch->num);
+	if(n == EOF)
+	{
+		return 0; // empty line
+	}
+
+	// compare against remaining slots, as lc + num may wrap around
+	if(  (n < 4) || (patch->lu >= MAX_UNIVERSES) || (patch->pu >= MAX_UNIVERSES)
+		|| (patch->lc >= 512) || (patch->ps >= 512)
+		|| (patch->num > 512 - patch->lc) || (patch->num > 512 - patch->ps) )
+	{
+		return -1;
+	}
+
+	return 1;
+}
+
+void
+hist_clear(hist_t *hist)
+{
+	memset(hist, 0x0, sizeof(hist_t));
+
+	hist->min = UINT64_MAX;
+}
+
+void
+hist_add(hist_t *hist, uint64_t ns)
+{
+	// bucket i holds durations in [2^i, 2^(i+1)) ns, bucket 0 also holds 0
+	uint32_t i = ns
+		? 63 - __builtin_clzll(ns)
+		: 0;
+
+	if(i >= HIST_BUCKETS)
+	{
+		i = HIST_BUCKETS - 1;
+	}
+
+	hist->buckets[i]++;
+	hist->count++;
+
+	if(ns < hist->min)
+	{
+		hist->min = ns;
+	}
+
+	if(ns > hist->max)
+	{
+		hist->max = ns;
+	}
+}
+
+void
+hist_merge(hist_t *dst, const hist_t *src)
+{
+	for(uint32_t i = 0; i < HIST_BUCKETS; i++)
+	{
+		dst->buckets[i] += src->buckets[i];
+	}
+
+	dst->count += src->count;
+
+	if(src->min < dst->min)
+	{
+		dst->min = src->min;
+	}
+
+	if(src->max > dst->max)
+	{
+		dst->max = src->max;
+	}
+}
+
+uint64_t
+hist_quantile(const hist_t *hist, double q)
+{
+	// upper bound of the bucket which holds given quantile
+	const double thresh = q * hist->count;
+	uint64_t sum = 0;
+
+	for(uint32_t i = 0; i < HIST_BUCKETS; i++)
+	{
+		sum += hist->buckets[i];
+
+		if( (sum > 0) && (sum >= thresh) )
+		{
+			return UINT64_C(1) << (i + 1);
+		}
+	}
+
+	return 0;
+}
+
+uint64_t
+dmx_wire_ns(uint32_t slots)
+{
+	// 1 start bit + 8 data bits + 2 stop bits at 250 kbaud = 44 us per slot
+	return (uint64_t)slots * 44000;
+}
+
+uint64_t
+dmx_frame_ns(uint32_t break_us, uint32_t mab_us, uint32_t slots)
+{
+	uint64_t frame_ns = (uint64_t)(break_us + mab_us) * 1000 + dmx_wire_ns(slots);
+
+	// minimal break-to-break time as of DMX512-A
+	if(frame_ns < 1204000)
+	{
+		frame_ns = 1204000;
+	}
+
+	return frame_ns;
+}
+
+static void
+_apply(state_t *state, uint8_t prio)
+{
 	if(state->cur_arg && !lv2_osc_reader_arg_is_end(&state->cur_reader, state->cur_arg))
 	{
 		switch(state->cur_arg->type[0])
@@ -85,26 +308,41 @@ _priority (LV2_OSC_Reader *reader __attribute__((unused)),
 		state->cur_arg = lv2_osc_reader_arg_next(&state->cur_reader, state->cur_arg);
 	}
 
-	slot_t *slot = &state->slots[state->cur_channel];
+	// universes are allocated up front, never on the realtime dispatch path
+	universe_t *univ = state_universe(state, state->cur_universe, false);
+	if(!univ)
+	{
+		return; // universe is neither mapped nor patched
+	}
 
-	fprintf(stderr, "%u %u\n", state->cur_channel, prio);
+	slot_t *slot = &univ->slots[state->cur_channel];
 
 	if(state->cur_set)
 	{
 		slot_set_val(slot, prio, state->cur_value);
 
-		syslog(LOG_DEBUG, "[%s] SET chan: %"PRIu16" prio: %"PRIu8" val: %"PRIu8,
-			__func__, state->cur_channel, prio, state->cur_value);
+		syslog(LOG_DEBUG, "[%s] SET univ: %"PRIu16" chan: %"PRIu16" prio: %"PRIu8" val: %"PRIu8,
+			__func__, state->cur_universe, state->cur_channel, prio, state->cur_value);
 	}
 	else
 	{
 		slot_clr_val(slot, prio);
 
-		syslog(LOG_DEBUG, "[%s] CLEAR chan: %"PRIu16" prio: %"PRIu8,
-			__func__, state->cur_channel, prio);
+		syslog(LOG_DEBUG, "[%s] CLEAR univ: %"PRIu16" chan: %"PRIu16" prio: %"PRIu8,
+			__func__, state->cur_universe, state->cur_channel, prio);
 	}
 }
 
+static void
+_priority (LV2_OSC_Reader *reader __attribute__((unused)),
+	LV2_OSC_Arg *arg __attribute__((unused)), const LV2_OSC_Tree *tree, void *data)
+{
+	state_t *state = data;
+
+	// only record, _match applies per universe
+	state->cur_match[state->cur_channel] |= UINT32_C(1) << (tree - tree_priority);
+}
+
 static void
 _channel( LV2_OSC_Reader *reader __attribute__((unused)),
 	LV2_OSC_Arg *arg __attribute__((unused)), const LV2_OSC_Tree *tree, void *data)
@@ -666,7 +904,209 @@ static const LV2_OSC_Tree tree_channel [512+1] = {
 	{ .name = NULL }
 };
 
-const LV2_OSC_Tree tree_root [1+1] = {
-	{ .name = "dmx", .trees = tree_channel },
-	{ .name = NULL }
-};
+static bool
+_index(const char **ptr, uint32_t *val, char term)
+{
+	const char *from = *ptr;
+	uint32_t v = 0;
+
+	if( (*from < '0') || (*from > '9') )
+	{
+		return false;
+	}
+
+	// leading zeros would not match the tree names of patterns either
+	if( (from[0] == '0') && (from[1] >= '0') && (from[1] <= '9') )
+	{
+		return false;
+	}
+
+	for( ; (*from >= '0') && (*from <= '9'); from++)
+	{
+		v = v*10 + (*from - '0');
+
+		if(v > UINT16_MAX)
+		{
+			return false;
+		}
+	}
+
+	if(*from != term)
+	{
+		return false;
+	}
+
+	*ptr = from + 1;
+	*val = v;
+
+	return true;
+}
+
+static void
+_match_apply(state_t *state, uint32_t universe)
+{
+	state->cur_universe = universe;
+
+	for(uint32_t channel = 0; channel < 512; channel++)
+	{
+		state->cur_channel = channel;
+
+		for(uint32_t match = state->cur_match[channel]; match; match &= match - 1)
+		{
+			_apply(state, __builtin_ctz(match));
+		}
+	}
+}
+
+static void
+_match(state_t *state, LV2_OSC_Reader *reader, size_t len)
+{
+	const char *from = &state->cur_arg->path[5];
+	const char *end = strchr(from, '/');
+
+	if(!end)
+	{
+		return; // no channel component
+	}
+
+	const size_t nfrom = end - from;
+	char name [8];
+	const LV2_OSC_Tree tree_universe [1+1] = {
+		{ .name = name, .trees = tree_channel },
+		{ .name = NULL }
+	};
+	const LV2_OSC_Tree tree_root [1+1] = {
+		{ .name = "dmx", .trees = tree_universe },
+		{ .name = NULL }
+	};
+	bool walked = false;
+
+	memset(state->cur_match, 0x0, sizeof(state->cur_match));
+
+	// plain universe
+	const char *ptr = from;
+	uint32_t universe;
+
+	if(_index(&ptr, &universe, '/'))
+	{
+		if( (universe < MAX_UNIVERSES) && state->universes[universe])
+		{
+			snprintf(name, sizeof(name), "%"PRIu32, universe);
+			lv2_osc_reader_match(reader, len, tree_root, state);
+			_match_apply(state, universe);
+		}
+
+		return;
+	}
+
+	// patterns only match allocated universes
+	for(uint32_t i = 0; i < MAX_UNIVERSES / 64; i++)
+	{
+		for(uint64_t used = state->used[i]; used; used &= used - 1)
+		{
+			universe = i*64 + __builtin_ctzll(used);
+
+			snprintf(name, sizeof(name), "%"PRIu32, universe);
+
+			if(!lv2_osc_pattern_match(from, name, nfrom))
+			{
+				continue;
+			}
+
+			// channel and priority components are matched only once
+			if(!walked)
+			{
+				LV2_OSC_Reader reader_clone = *reader;
+				lv2_osc_reader_match(&reader_clone, len, tree_root, state);
+				walked = true;
+			}
+
+			_match_apply(state, universe);
+		}
+	}
+}
+
+void
+state_dispatch(state_t *state, LV2_OSC_Reader *reader, size_t len)
+{
+	state->cur_universe = 0;
+	state->cur_channel = 0;
+	state->cur_value = 0;
+	state->cur_set = false;
+
+	state->cur_reader = *reader;
+	state->cur_arg = OSC_READER_MESSAGE_BEGIN(&state->cur_reader, len);
+
+	if(!state->cur_arg || (strncmp(state->cur_arg->path, "/dmx/", 5) != 0) )
+	{
+		return;
+	}
+
+	// constant-time fast path for plain /dmx/UNIVERSE/CHANNEL/PRIORITY
+	const char *ptr = &state->cur_arg->path[5];
+	uint32_t universe;
+	uint32_t channel;
+	uint32_t prio;
+
+	if(  _index(&ptr, &universe, '/')
+		&& _index(&ptr, &channel, '/')
+		&& _index(&ptr, &prio, '\0') )
+	{
+		if( (universe < MAX_UNIVERSES) && (channel < 512) && (prio < 32) )
+		{
+			state->cur_universe = universe;
+			state->cur_channel = channel;
+
+			_apply(state, prio);
+		}
+
+		return;
+	}
+
+	_match(state, reader, len);
+}
+
+int
+tty_setup(int fd, uint32_t baud, uint32_t stop_bits)
+{
+#if defined(TCSETS2)
+	struct termios2 tio;
+
+	if(ioctl(fd, TCGETS2, &tio) != 0)
+	{
+		return -1;
+	}
+
+	// raw 8N1 or 8N2 at arbitrary baud rate
+	tio.c_iflag = 0;
+	tio.c_oflag = 0;
+	tio.c_lflag = 0;
+	tio.c_cflag = BOTHER | CS8 | CLOCAL | CREAD | (stop_bits == 2 ? CSTOPB : 0);
+	tio.c_ispeed = baud;
+	tio.c_ospeed = baud;
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+
+	return ioctl(fd, TCSETS2, &tio);
+#else
+	(void)fd;
+	(void)baud;
+	(void)stop_bits;
+	errno = ENOTSUP;
+
+	return -1;
+#endif
+}
+
+size_t
+pro_pack(uint8_t *dst, uint8_t label, const uint8_t *src, uint16_t len)
+{
+	dst[0] = PRO_SOM;
+	dst[1] = label;
+	dst[2] = len & 0xff;
+	dst[3] = len >> 8;
+	memcpy(&dst[4], src, len);
+	dst[4 + len] = PRO_EOM;
+
+	return len + PRO_OVERHEAD;
+}
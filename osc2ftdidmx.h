@@ -28,21 +28,63 @@
 extern "C" {
 #endif
 
+#define HIST_BUCKETS 32
+#define DMX_MIN_SLOTS 24
+#define MAX_UNIVERSES 32768
+
+// DMX USB Pro widget framing
+#define PRO_SOM 0x7e
+#define PRO_EOM 0xe7
+#define PRO_LABEL_DMX 6
+#define PRO_OVERHEAD 5
+#define PRO_BAUD 57600
+
 typedef struct _slot_t slot_t;
+typedef struct _universe_t universe_t;
 typedef struct _state_t state_t;
+typedef struct _hist_t hist_t;
+typedef struct _gather_t gather_t;
+typedef struct _patch_t patch_t;
 
 struct _slot_t {
 	uint32_t mask;
 	uint8_t data [32];
 };
 
+struct _universe_t {
+	slot_t slots [512];
+};
+
 struct _state_t {
+	uint16_t cur_universe;
 	uint16_t cur_channel;
 	uint8_t cur_value;
 	bool cur_set;
 	LV2_OSC_Reader cur_reader;
 	LV2_OSC_Arg *cur_arg;
-	slot_t slots [512];
+	uint32_t cur_match [512];
+	uint64_t used [MAX_UNIVERSES / 64];
+	universe_t *universes [MAX_UNIVERSES];
+};
+
+struct _gather_t {
+	uint32_t nslots;
+	uint32_t idx [512];
+};
+
+struct _patch_t {
+	unsigned lu;
+	unsigned lc;
+	unsigned pu;
+	unsigned ps;
+	unsigned num;
+};
+
+struct _hist_t {
+	uint64_t count;
+	uint64_t min;
+	uint64_t max;
+	uint32_t buckets [HIST_BUCKETS];
 };
 
 void
@@ -57,7 +99,53 @@ slot_has_val(slot_t *slot);
 uint8_t
 slot_get_val(slot_t *slot);
 
-extern const LV2_OSC_Tree tree_root [];
+universe_t *
+state_universe(state_t *state, uint16_t universe, bool create);
+
+void
+state_deinit(state_t *state);
+
+void
+state_dispatch(state_t *state, LV2_OSC_Reader *reader, size_t len);
+
+uint32_t
+state_resolve(state_t *state, uint16_t universe, uint8_t *data);
+
+void
+gather_clear(gather_t *gather, uint32_t zero);
+
+void
+gather_set(gather_t *gather, uint32_t slot, uint32_t idx);
+
+void
+gather_run(const gather_t *gather, const uint8_t *src, uint8_t *dst);
+
+int
+patch_parse(char *line, patch_t *patch);
+
+void
+hist_clear(hist_t *hist);
+
+void
+hist_add(hist_t *hist, uint64_t ns);
+
+void
+hist_merge(hist_t *dst, const hist_t *src);
+
+uint64_t
+hist_quantile(const hist_t *hist, double q);
+
+uint64_t
+dmx_wire_ns(uint32_t slots);
+
+uint64_t
+dmx_frame_ns(uint32_t break_us, uint32_t mab_us, uint32_t slots);
+
+int
+tty_setup(int fd, uint32_t baud, uint32_t stop_bits);
+
+size_t
+pro_pack(uint8_t *dst, uint8_t label, const uint8_t *src, uint16_t len);
 
 #ifdef __cplusplus
 }
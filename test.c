@@ -17,6 +17,11 @@
 
 #include <assert.h>
 #include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
 
 #include <osc2ftdidmx.h>
 
@@ -68,6 +73,329 @@ _test_priorities()
 	assert(slot_get_val(&slot) == 0x0);
 }
 
+static void
+_test_resolve()
+{
+	state_t state;
+	uint8_t data [512];
+
+	// empty
+	memset(&state, 0x0, sizeof(state));
+	memset(data, 0xff, sizeof(data));
+	assert(state_resolve(&state, 0, data) == 0);
+	for(unsigned channel = 0; channel < 512; channel++)
+	{
+		assert(data[channel] == 0x0);
+	}
+
+	// highest active channel, even if its value is 0
+	universe_t *univ = state_universe(&state, 1, true);
+	assert(univ);
+	slot_set_val(&univ->slots[2], 0, 0x2);
+	slot_set_val(&univ->slots[63], 1, 0x0);
+	assert(state_resolve(&state, 1, data) == 64);
+	assert(data[2] == 0x2);
+	assert(data[63] == 0x0);
+
+	slot_clr_val(&univ->slots[63], 1);
+	assert(state_resolve(&state, 1, data) == 3);
+
+	// other universes untouched and not allocated
+	assert(state_resolve(&state, 0, data) == 0);
+	assert(data[2] == 0x0);
+	assert(state_universe(&state, 0, false) == NULL);
+
+	state_deinit(&state);
+	assert(state_universe(&state, 1, false) == NULL);
+}
+
+static void
+_test_gather()
+{
+	gather_t gather;
+	uint8_t src [2*512 + 1];
+	uint8_t dst [512];
+
+	for(unsigned i = 0; i < 2*512; i++)
+	{
+		src[i] = i % 251 + 1;
+	}
+	src[2*512] = 0x0;
+
+	// unpatched slots are blank
+	gather_clear(&gather, 2*512);
+	assert(gather.nslots == 0);
+	gather_run(&gather, src, dst);
+	for(unsigned slot = 0; slot < 512; slot++)
+	{
+		assert(dst[slot] == 0x0);
+	}
+
+	// swap and spread channels across logical universes
+	gather_set(&gather, 0, 512 + 7);
+	gather_set(&gather, 9, 3);
+	gather_set(&gather, 10, 3);
+	assert(gather.nslots == 11);
+	gather_run(&gather, src, dst);
+	assert(dst[0] == src[512 + 7]);
+	assert(dst[9] == src[3]);
+	assert(dst[10] == src[3]);
+	assert(dst[1] == 0x0);
+	assert(dst[511] == 0x0);
+}
+
+static void
+_test_patch()
+{
+	patch_t patch;
+
+	// valid lines, count defaults to one
+	{
+		char line [] = "1 2 3 4\n";
+		assert(patch_parse(line, &patch) == 1);
+		assert(patch.lu == 1);
+		assert(patch.lc == 2);
+		assert(patch.pu == 3);
+		assert(patch.ps == 4);
+		assert(patch.num == 1);
+	}
+	{
+		char line [] = "32767 0 0 500 12\n";
+		assert(patch_parse(line, &patch) == 1);
+		assert(patch.lu == 32767);
+		assert(patch.ps == 500);
+		assert(patch.num == 12);
+	}
+
+	// comments and empty lines
+	{
+		char line [] = "0 0 0 0 8 # front truss\n";
+		assert(patch_parse(line, &patch) == 1);
+		assert(patch.num == 8);
+	}
+	{
+		char line [] = "# 0 0 0 0\n";
+		assert(patch_parse(line, &patch) == 0);
+	}
+	{
+		char line [] = "   \n";
+		assert(patch_parse(line, &patch) == 0);
+	}
+
+	// incomplete lines
+	{
+		char line [] = "0 0 0\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+
+	// out-of-range universes and slots
+	{
+		char line [] = "32768 0 0 0\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+	{
+		char line [] = "0 0 32768 0\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+	{
+		char line [] = "0 512 0 0\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+	{
+		char line [] = "0 0 0 512\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+	{
+		char line [] = "0 -1 0 0\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+
+	// ranges must end within the universe
+	{
+		char line [] = "0 500 0 0 12\n";
+		assert(patch_parse(line, &patch) == 1);
+	}
+	{
+		char line [] = "0 500 0 0 13\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+	{
+		char line [] = "0 0 0 511 2\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+
+	// counts which would wrap lc + num or ps + num around
+	{
+		char line [] = "0 1 0 0 4294967295\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+	{
+		char line [] = "0 0 0 1 4294967295\n";
+		assert(patch_parse(line, &patch) == -1);
+	}
+}
+
+static void
+_test_hist()
+{
+	hist_t hist;
+
+	// empty
+	hist_clear(&hist);
+	assert(hist.count == 0);
+	assert(hist.min == UINT64_MAX);
+	assert(hist.max == 0);
+
+	// log2 buckets
+	hist_add(&hist, 0);
+	hist_add(&hist, 1);
+	hist_add(&hist, 2);
+	hist_add(&hist, 3);
+	hist_add(&hist, 1000);
+	assert(hist.count == 5);
+	assert(hist.min == 0);
+	assert(hist.max == 1000);
+	assert(hist.buckets[0] == 2);
+	assert(hist.buckets[1] == 2);
+	assert(hist.buckets[9] == 1);
+
+	// quantiles
+	assert(hist_quantile(&hist, 0.0) == 1 << 1);
+	assert(hist_quantile(&hist, 0.5) == 1 << 2);
+	assert(hist_quantile(&hist, 1.0) == 1 << 10);
+
+	// merge
+	hist_t sum;
+	hist_clear(&sum);
+	hist_merge(&sum, &hist);
+	hist_merge(&sum, &hist);
+	assert(sum.count == 10);
+	assert(sum.min == 0);
+	assert(sum.max == 1000);
+	assert(sum.buckets[1] == 4);
+
+	// saturate in last bucket
+	hist_add(&hist, UINT64_MAX);
+	assert(hist.buckets[HIST_BUCKETS - 1] == 1);
+	assert(hist.max == UINT64_MAX);
+}
+
+static void
+_test_timing()
+{
+	// full universe with start code
+	assert(dmx_frame_ns(176, 12, 513) == 22760000);
+	assert(dmx_frame_ns(88, 8, 513) == 22668000);
+
+	// minimal break-to-break time
+	assert(dmx_frame_ns(88, 8, 25) == 1204000);
+
+	// slots only
+	assert(dmx_wire_ns(513) == 22572000);
+}
+
+static void
+_test_tty()
+{
+	// pty stands in for a serial adapter
+	const int master = posix_openpt(O_RDWR | O_NOCTTY);
+	assert(master != -1);
+	assert(grantpt(master) == 0);
+	assert(unlockpt(master) == 0);
+
+	const int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+	assert(slave != -1);
+
+	assert(tty_setup(slave, 250000, 2) == 0);
+
+	// bytes must pass without line discipline processing
+	const uint8_t frame [] = { 0x0, '\n', '\r', 0x3, 0x11, 0x13, 0x7f, 0xff };
+	uint8_t dump [sizeof(frame)];
+
+	assert(write(slave, frame, sizeof(frame)) == sizeof(frame));
+	assert(read(master, dump, sizeof(dump)) == sizeof(dump));
+	assert(memcmp(frame, dump, sizeof(frame)) == 0);
+
+	close(slave);
+	close(master);
+}
+
+static void
+_test_pro()
+{
+	const uint8_t frame [3] = { 0x0, 0x1, 0xff };
+	uint8_t buf [PRO_OVERHEAD + sizeof(frame)];
+
+	assert(pro_pack(buf, PRO_LABEL_DMX, frame, sizeof(frame)) == sizeof(buf));
+	assert(buf[0] == PRO_SOM);
+	assert(buf[1] == PRO_LABEL_DMX);
+	assert(buf[2] == sizeof(frame));
+	assert(buf[3] == 0x0);
+	assert(memcmp(&buf[4], frame, sizeof(frame)) == 0);
+	assert(buf[sizeof(buf) - 1] == PRO_EOM);
+
+	// length in little endian
+	uint8_t big [PRO_OVERHEAD + 513];
+	uint8_t slots [513] = { 0x0 };
+
+	assert(pro_pack(big, PRO_LABEL_DMX, slots, sizeof(slots)) == sizeof(big));
+	assert(big[2] == 0x01);
+	assert(big[3] == 0x02);
+}
+
+static void
+_test_pro_tty()
+{
+	// pty stands in for a widget emulator on a serial device
+	const int master = posix_openpt(O_RDWR | O_NOCTTY);
+	assert(master != -1);
+	assert(grantpt(master) == 0);
+	assert(unlockpt(master) == 0);
+
+	const int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+	assert(slave != -1);
+
+	assert(tty_setup(slave, PRO_BAUD, 1) == 0);
+
+	// widget link is 8N1, unlike the DMX line
+	struct termios2 tio;
+	assert(ioctl(slave, TCGETS2, &tio) == 0);
+	assert((tio.c_cflag & CSIZE) == CS8);
+	assert((tio.c_cflag & CSTOPB) == 0);
+	assert(tio.c_ospeed == PRO_BAUD);
+
+	uint8_t slots [513];
+	uint8_t buf [PRO_OVERHEAD + sizeof(slots)];
+
+	for(unsigned i = 0; i < sizeof(slots); i++)
+	{
+		slots[i] = i; // includes PRO_SOM and PRO_EOM as payload
+	}
+
+	const size_t sz = pro_pack(buf, PRO_LABEL_DMX, slots, sizeof(slots));
+	assert(write(slave, buf, sz) == (ssize_t)sz);
+
+	// emulator reads and validates the framed packet
+	uint8_t dump [sizeof(buf)];
+	size_t len = 0;
+
+	while(len < sizeof(dump))
+	{
+		const ssize_t res = read(master, &dump[len], sizeof(dump) - len);
+		assert(res > 0);
+		len += res;
+	}
+
+	assert(dump[0] == PRO_SOM);
+	assert(dump[1] == PRO_LABEL_DMX);
+	assert( (dump[2] | (dump[3] << 8)) == sizeof(slots) );
+	assert(memcmp(&dump[4], slots, sizeof(slots)) == 0);
+	assert(dump[4 + sizeof(slots)] == PRO_EOM);
+
+	close(slave);
+	close(master);
+}
+
 static void
 _test_parse()
 {
@@ -78,7 +406,7 @@ _test_parse()
 		const uint8_t msg [] = {
 			'/', 'd', 'm', 'x',
 			'/', '*', '/', '*',
-			0x0, 0x0, 0x0, 0x0,
+			'/', '*', 0x0, 0x0,
 			',', 0x0, 0x0, 0x0
 		};
 
@@ -86,24 +414,28 @@ _test_parse()
 		lv2_osc_reader_initialize(&reader, msg, sizeof(msg));
 
 		memset(&state, 0x0, sizeof(state));
-		state.cur_reader = reader;
-		state.cur_arg = OSC_READER_MESSAGE_BEGIN(&state.cur_reader, sizeof(msg));
-		lv2_osc_reader_match(&reader, sizeof(msg), tree_root, &state);
+		assert(state_universe(&state, 0, true));
+		state_dispatch(&state, &reader, sizeof(msg));
 
 		for(unsigned channel = 0; channel < 512; channel++)
 		{
-			slot_t *slot = &state.slots[channel];
+			slot_t *slot = &state.universes[0]->slots[channel];
 
 			assert(slot_has_val(slot) == false);
 			assert(slot_get_val(slot) == 0x0);
 		}
+
+		// clearing does not allocate
+		assert(state.universes[1] == NULL);
+
+		state_deinit(&state);
 	}
 
 	{
 		const uint8_t msg [] = {
 			'/', 'd', 'm', 'x',
 			'/', '*', '/', '*',
-			0x0, 0x0, 0x0, 0x0,
+			'/', '*', 0x0, 0x0,
 			',', 'i', 0x0, 0x0,
 			0x0, 0x0, 0x0, 0x1
 		};
@@ -112,24 +444,32 @@ _test_parse()
 		lv2_osc_reader_initialize(&reader, msg, sizeof(msg));
 
 		memset(&state, 0x0, sizeof(state));
-		state.cur_reader = reader;
-		state.cur_arg = OSC_READER_MESSAGE_BEGIN(&state.cur_reader, sizeof(msg));
-		lv2_osc_reader_match(&reader, sizeof(msg), tree_root, &state);
+		assert(state_universe(&state, 0, true));
+		assert(state_universe(&state, 2, true));
+		state_dispatch(&state, &reader, sizeof(msg));
 
-		for(unsigned channel = 0; channel < 512; channel++)
+		// patterns only match existing universes
+		for(unsigned universe = 0; universe < 3; universe += 2)
 		{
-			slot_t *slot = &state.slots[channel];
+			for(unsigned channel = 0; channel < 512; channel++)
+			{
+				slot_t *slot = &state.universes[universe]->slots[channel];
 
-			assert(slot_has_val(slot) == true);
-			assert(slot_get_val(slot) == 0x1);
+				assert(slot_has_val(slot) == true);
+				assert(slot_get_val(slot) == 0x1);
+			}
 		}
+
+		assert(state.universes[1] == NULL);
+
+		state_deinit(&state);
 	}
 
 	{
 		const uint8_t msg1 [] = {
 			'/', 'd', 'm', 'x',
-			'/', '2', '/', '2',
-			0x0, 0x0, 0x0, 0x0,
+			'/', '1', '/', '2',
+			'/', '2', 0x0, 0x0,
 			',', 'i', 0x0, 0x0,
 			0x0, 0x0, 0x0, 0x2
 		};
@@ -138,17 +478,12 @@ _test_parse()
 		lv2_osc_reader_initialize(&reader, msg1, sizeof(msg1));
 
 		memset(&state, 0x0, sizeof(state));
-		state.cur_channel = 0;
-		state.cur_value = 0;
-		state.cur_set = false;
-
-		state.cur_reader = reader;
-		state.cur_arg = OSC_READER_MESSAGE_BEGIN(&state.cur_reader, sizeof(msg1));
-		lv2_osc_reader_match(&reader, sizeof(msg1), tree_root, &state);
+		assert(state_universe(&state, 1, true));
+		state_dispatch(&state, &reader, sizeof(msg1));
 
 		for(unsigned channel = 0; channel < 512; channel++)
 		{
-			slot_t *slot = &state.slots[channel];
+			slot_t *slot = &state.universes[1]->slots[channel];
 
 			if(channel == 0x2)
 			{
@@ -164,8 +499,8 @@ _test_parse()
 
 		const uint8_t msg2 [] = {
 			'/', 'd', 'm', 'x',
-			'/', '2', '/', '3',
-			0x0, 0x0, 0x0, 0x0,
+			'/', '1', '/', '2',
+			'/', '3', 0x0, 0x0,
 			',', 'i', 0x0, 0x0,
 			0x0, 0x0, 0x0, 0x3
 		};
@@ -174,17 +509,11 @@ _test_parse()
 		lv2_osc_reader_initialize(&reader, msg2, sizeof(msg2));
 
 		//memset(&state, 0x0, sizeof(state));
-		state.cur_channel = 0;
-		state.cur_value = 0;
-		state.cur_set = false;
-
-		state.cur_reader = reader;
-		state.cur_arg = OSC_READER_MESSAGE_BEGIN(&state.cur_reader, sizeof(msg2));
-		lv2_osc_reader_match(&reader, sizeof(msg2), tree_root, &state);
+		state_dispatch(&state, &reader, sizeof(msg2));
 
 		for(unsigned channel = 0; channel < 512; channel++)
 		{
-			slot_t *slot = &state.slots[channel];
+			slot_t *slot = &state.universes[1]->slots[channel];
 
 			if(channel == 0x2)
 			{
@@ -198,8 +527,10 @@ _test_parse()
 			}
 		}
 
+		// pattern fallback
 		const uint8_t msg3 [] = {
 			'/', 'd', 'm', 'x',
+			'/', '[', '1', ']',
 			'/', '2', '/', '2',
 			0x0, 0x0, 0x0, 0x0,
 			',', 0x0, 0x0, 0x0
@@ -209,17 +540,11 @@ _test_parse()
 		lv2_osc_reader_initialize(&reader, msg3, sizeof(msg3));
 
 		//memset(&state, 0x0, sizeof(state));
-		state.cur_channel = 0;
-		state.cur_value = 0;
-		state.cur_set = false;
-
-		state.cur_reader = reader;
-		state.cur_arg = OSC_READER_MESSAGE_BEGIN(&state.cur_reader, sizeof(msg3));
-		lv2_osc_reader_match(&reader, sizeof(msg3), tree_root, &state);
+		state_dispatch(&state, &reader, sizeof(msg3));
 
 		for(unsigned channel = 0; channel < 512; channel++)
 		{
-			slot_t *slot = &state.slots[channel];
+			slot_t *slot = &state.universes[1]->slots[channel];
 
 			if(channel == 0x2)
 			{
@@ -235,8 +560,8 @@ _test_parse()
 
 		const uint8_t msg4 [] = {
 			'/', 'd', 'm', 'x',
-			'/', '2', '/', '3',
-			0x0, 0x0, 0x0, 0x0,
+			'/', '1', '/', '2',
+			'/', '3', 0x0, 0x0,
 			',', 0x0, 0x0, 0x0
 		};
 
@@ -244,17 +569,11 @@ _test_parse()
 		lv2_osc_reader_initialize(&reader, msg4, sizeof(msg4));
 
 		//memset(&state, 0x0, sizeof(state));
-		state.cur_channel = 0;
-		state.cur_value = 0;
-		state.cur_set = false;
-
-		state.cur_reader = reader;
-		state.cur_arg = OSC_READER_MESSAGE_BEGIN(&state.cur_reader, sizeof(msg4));
-		lv2_osc_reader_match(&reader, sizeof(msg4), tree_root, &state);
+		state_dispatch(&state, &reader, sizeof(msg4));
 
 		for(unsigned channel = 0; channel < 512; channel++)
 		{
-			slot_t *slot = &state.slots[channel];
+			slot_t *slot = &state.universes[1]->slots[channel];
 
 			if(channel == 0x2)
 			{
@@ -268,7 +587,89 @@ _test_parse()
 			}
 		}
 
-		//FIXME clear 3 and test
+		// only addressed universe allocated
+		assert(state.universes[0] == NULL);
+
+		state_deinit(&state);
+	}
+
+	{
+		const uint8_t msg1 [] = {
+			'/', 'd', 'm', 'x',
+			'/', '[', '0', '2',
+			']', '/', '1', '/',
+			'*', 0x0, 0x0, 0x0,
+			',', 'i', 0x0, 0x0,
+			0x0, 0x0, 0x0, 0x5
+		};
+
+		memset(&reader, 0x0, sizeof(reader));
+		lv2_osc_reader_initialize(&reader, msg1, sizeof(msg1));
+
+		memset(&state, 0x0, sizeof(state));
+		assert(state_universe(&state, 0, true));
+		assert(state_universe(&state, 1, true));
+		assert(state_universe(&state, 2, true));
+		state_dispatch(&state, &reader, sizeof(msg1));
+
+		// universe pattern only matches its universes
+		for(unsigned universe = 0; universe < 3; universe++)
+		{
+			slot_t *slot = &state.universes[universe]->slots[1];
+
+			assert(slot_has_val(slot) == (universe != 1));
+			assert(slot_get_val(slot) == (universe != 1 ? 0x5 : 0x0));
+			assert(slot_has_val(&state.universes[universe]->slots[0]) == false);
+		}
+
+		const uint8_t msg2 [] = {
+			'/', 'd', 'm', 'x',
+			'/', '3', '/', '*',
+			'/', '1', 0x0, 0x0,
+			',', 'i', 0x0, 0x0,
+			0x0, 0x0, 0x0, 0x4
+		};
+
+		memset(&reader, 0x0, sizeof(reader));
+		lv2_osc_reader_initialize(&reader, msg2, sizeof(msg2));
+
+		state_dispatch(&state, &reader, sizeof(msg2));
+
+		// dispatch never allocates
+		assert(state.universes[3] == NULL);
+
+		assert(state_universe(&state, 3, true));
+
+		memset(&reader, 0x0, sizeof(reader));
+		lv2_osc_reader_initialize(&reader, msg2, sizeof(msg2));
+
+		state_dispatch(&state, &reader, sizeof(msg2));
+
+		for(unsigned channel = 0; channel < 512; channel++)
+		{
+			slot_t *slot = &state.universes[3]->slots[channel];
+
+			assert(slot_has_val(slot) == true);
+			assert(slot_get_val(slot) == 0x4);
+		}
+
+		const uint8_t msg3 [] = {
+			'/', 'd', 'm', 'x',
+			'/', '0', '1', '/',
+			'1', '/', '0', 0x0,
+			',', 'i', 0x0, 0x0,
+			0x0, 0x0, 0x0, 0x9
+		};
+
+		memset(&reader, 0x0, sizeof(reader));
+		lv2_osc_reader_initialize(&reader, msg3, sizeof(msg3));
+
+		state_dispatch(&state, &reader, sizeof(msg3));
+
+		// leading zeros address nothing, neither plain nor as pattern
+		assert(slot_has_val(&state.universes[1]->slots[1]) == false);
+
+		state_deinit(&state);
 	}
 }
 
@@ -276,6 +677,14 @@ int
 main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
 {
 	_test_priorities();
+	_test_resolve();
+	_test_gather();
+	_test_patch();
+	_test_hist();
+	_test_timing();
+	_test_tty();
+	_test_pro();
+	_test_pro_tty();
 	_test_parse();
 
 	return 0;